@@ -0,0 +1,307 @@
+/*
+
+ FLTK Gomoku - bitboard line counting
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "bitboard.h"
+#include "engine.h"
+#include <cstring>
+#include <chrono>
+
+// Line layout (see ::count() for the directions of Eval::info[1..4]):
+//  dir 1 ( 1, 0): line y,          bit x, '+' direction is up
+//  dir 2 ( 0, 1): line x,          bit y, '+' direction is up
+//  dir 3 (-1,-1): line x - y + BS, bit x, '+' direction is down
+//  dir 4 ( 1,-1): line x + y,      bit x, '+' direction is up
+
+#if defined( __GNUC__ )
+// The four lines through a cell are masked in one vector operation
+// (SSE2/AVX2/NEON, depending on the target). The run lengths need a bit
+// scan per lane, as there is no vector instruction for it before AVX-512.
+typedef uint32_t V4 __attribute__(( vector_size( 16 ) ));
+#define HAVE_V4
+#endif
+
+static inline int upRun( uint32_t mask_, int from_ )
+//-------------------------------------------------------------------------------
+{
+	// number of consecutive set bits starting at bit from_ upwards
+	if ( from_ >= 32 )
+		return 0;
+	uint64_t m = mask_ >> from_;
+	return __builtin_ctzll( ~m );
+}
+
+static inline int downRun( uint32_t mask_, int from_ )
+//-------------------------------------------------------------------------------
+{
+	// number of consecutive set bits starting at bit from_ downwards
+	if ( from_ < 0 )
+		return 0;
+	uint64_t m = (uint64_t)mask_ << ( 63 - from_ );
+	return __builtin_clzll( ~m );
+}
+
+// Pattern table: the index is the base 3 number of the 2 * WINDOW cells
+// around the center (0 = empty, 1 = own, 2 = other/border), lowest digit
+// is the farthest cell in '-' direction. An entry is packed as
+// n (bits 0-3), f1 (bits 4-6), f2 (bits 7-9) and gap (bit 10).
+static const int WINDOW_CELLS = 2 * BitBoard::WINDOW;
+static const int PATTERNS = 59049; // 3^WINDOW_CELLS
+static uint16_t Base3[1 << WINDOW_CELLS]; // bit mask => base 3 digits 0/1
+static double TableTime = 0;
+
+/*static*/
+const uint16_t *BitBoard::patternTable()
+//-------------------------------------------------------------------------------
+{
+	static const uint16_t *table = []()
+	{
+		auto start = std::chrono::steady_clock::now();
+		for ( int m = 0; m < ( 1 << WINDOW_CELLS ); m++ )
+		{
+			int v = 0;
+			for ( int i = WINDOW_CELLS - 1; i >= 0; i-- )
+				v = v * 3 + ( ( m >> i ) & 1 );
+			Base3[m] = v;
+		}
+		static uint16_t patterns[PATTERNS];
+		for ( int p = 0; p < PATTERNS; p++ )
+		{
+			// center cell is own at bit WINDOW, cells beyond the window are blocked
+			uint32_t own = 1u << WINDOW;
+			uint32_t empty = 0;
+			int v = p;
+			for ( int i = 0; i < WINDOW_CELLS; i++, v /= 3 )
+			{
+				uint32_t b = 1u << ( i < WINDOW ? i : i + 1 );
+				if ( v % 3 == 0 )
+					empty |= b;
+				else if ( v % 3 == 1 )
+					own |= b;
+			}
+			PosInfo info;
+			countLine( own, empty, WINDOW, true, info );
+			patterns[p] = info.n | info.f1 << 4 | info.f2 << 7 | info.gap << 10;
+		}
+		TableTime = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+		return patterns;
+	}();
+	return table;
+}
+
+/*static*/
+size_t BitBoard::tableSize()
+//-------------------------------------------------------------------------------
+{
+	return PATTERNS * sizeof( uint16_t ) + sizeof( Base3 );
+}
+
+/*static*/
+double BitBoard::tableTime()
+//-------------------------------------------------------------------------------
+{
+	patternTable();
+	return TableTime;
+}
+
+BitBoard::BitBoard( int size_/* = 19*/ ) :
+	_table( patternTable() )
+//-------------------------------------------------------------------------------
+{
+	clear( size_ );
+}
+
+void BitBoard::clear( int size_ )
+//-------------------------------------------------------------------------------
+{
+	_BS = size_;
+	memset( _lines, 0, sizeof( _lines ) );
+	memset( _valid, 0, sizeof( _valid ) );
+	for ( int x = 1; x <= _BS; x++ )
+		for ( int y = 1; y <= _BS; y++ )
+			for ( int dir = 1; dir <= 4; dir++ )
+				_valid[dir][line( x, y, dir )] |= 1u << bit( x, y, dir );
+}
+
+int BitBoard::line( int x_, int y_, int dir_ ) const
+//-------------------------------------------------------------------------------
+{
+	switch ( dir_ )
+	{
+		case 1: return y_;
+		case 2: return x_;
+		case 3: return x_ - y_ + _BS;
+		default: return x_ + y_;
+	}
+}
+
+void BitBoard::set( int x_, int y_, int who_ )
+//-------------------------------------------------------------------------------
+{
+	for ( int dir = 1; dir <= 4; dir++ )
+		_lines[who_][dir][line( x_, y_, dir )] |= 1u << bit( x_, y_, dir );
+}
+
+void BitBoard::remove( int x_, int y_, int who_ )
+//-------------------------------------------------------------------------------
+{
+	for ( int dir = 1; dir <= 4; dir++ )
+		_lines[who_][dir][line( x_, y_, dir )] &= ~( 1u << bit( x_, y_, dir ) );
+}
+
+/*static*/
+void BitBoard::countLine( uint32_t own_, uint32_t empty_, int pos_, bool up_, PosInfo& info_ )
+//-------------------------------------------------------------------------------
+{
+	// own_ must contain the piece at pos_, empty_ must not
+	info_.init();
+	int up = upRun( own_, pos_ + 1 );
+	int down = downRun( own_, pos_ - 1 );
+	info_.n = 1 + up + down;
+	// if five or more everything else is unimportant
+	if ( info_.n >= 5 )
+		return;
+
+	// freedoms and same color after them on each side
+	int e = pos_ + up + 1;
+	int fu = upRun( empty_, e );
+	int nu = upRun( own_, e + fu );
+	e = pos_ - down - 1;
+	int fd = downRun( empty_, e );
+	int nd = downRun( own_, e - fd );
+
+	int n1 = up_ ? nu : nd;
+	int n2 = up_ ? nd : nu;
+	info_.f1 = up_ ? fu : fd;
+	info_.f2 = up_ ? fd : fu;
+
+	// same as in ::count()
+	int n = info_.n;
+	if ( info_.f1 == 1 ) // gap of 1
+	{
+		int t = info_.n + 1 + n1;
+		if ( t <= 5 )
+			n = info_.n + n1;
+	}
+	if ( info_.f2 == 1 ) // gap of 1
+	{
+		int t = info_.n + 1 + n2;
+		if ( t <= 5 && t > n )
+			n = info_.n + n2;
+	}
+	info_.gap = n != info_.n ? 1 : 0;
+	info_.n = n;
+}
+
+void BitBoard::count( int x_, int y_, int dir_, int who_, PosInfo& info_ ) const
+//-------------------------------------------------------------------------------
+{
+	int l = line( x_, y_, dir_ );
+	uint32_t b = 1u << bit( x_, y_, dir_ );
+	uint32_t own = _lines[who_][dir_][l] | b;
+	uint32_t empty = _valid[dir_][l] & ~( _lines[1][dir_][l] | _lines[2][dir_][l] | b );
+	countLine( own, empty, bit( x_, y_, dir_ ), dir_ != 3, info_ );
+}
+
+void BitBoard::countPos( int x_, int y_, int who_, Eval& pos_ ) const
+//-------------------------------------------------------------------------------
+{
+	int l1 = y_;
+	int l2 = x_;
+	int l3 = x_ - y_ + _BS;
+	int l4 = x_ + y_;
+#ifdef HAVE_V4
+	int opp = 3 - who_;
+	V4 b = { 1u << x_, 1u << y_, 1u << x_, 1u << x_ };
+	V4 own = { _lines[who_][1][l1], _lines[who_][2][l2], _lines[who_][3][l3], _lines[who_][4][l4] };
+	V4 other = { _lines[opp][1][l1], _lines[opp][2][l2], _lines[opp][3][l3], _lines[opp][4][l4] };
+	V4 valid = { _valid[1][l1], _valid[2][l2], _valid[3][l3], _valid[4][l4] };
+	V4 empty = valid & ~( own | other | b );
+	own |= b;
+	countLine( own[0], empty[0], x_, true, pos_.info[1] );
+	countLine( own[1], empty[1], y_, true, pos_.info[2] );
+	countLine( own[2], empty[2], x_, false, pos_.info[3] );
+	countLine( own[3], empty[3], x_, true, pos_.info[4] );
+#else
+	(void)l1; (void)l2; (void)l3; (void)l4;
+	for ( int dir = 1; dir <= 4; dir++ )
+		count( x_, y_, dir, who_, pos_.info[dir] );
+#endif
+}
+
+/*static*/
+int BitBoard::window( uint32_t own_, uint32_t empty_, int pos_ )
+//-------------------------------------------------------------------------------
+{
+	// table index of the cells around pos_ (own_/empty_ without pos_)
+	const uint32_t mask = ( 1u << ( WINDOW_CELLS + 1 ) ) - 1;
+	uint32_t own = (uint32_t)( (uint64_t)own_ << WINDOW >> pos_ ) & mask;
+	uint32_t other = ~( own | (uint32_t)( (uint64_t)empty_ << WINDOW >> pos_ ) ) & mask;
+	// remove the center
+	own = ( own & ( ( 1u << WINDOW ) - 1 ) ) | ( own >> ( WINDOW + 1 ) << WINDOW );
+	other = ( other & ( ( 1u << WINDOW ) - 1 ) ) | ( other >> ( WINDOW + 1 ) << WINDOW );
+	return Base3[own] + 2 * Base3[other];
+}
+
+/*static*/
+void BitBoard::unpack( uint16_t entry_, bool up_, PosInfo& info_ )
+//-------------------------------------------------------------------------------
+{
+	// (the table is built for the '+' direction going up)
+	info_.n = entry_ & 15;
+	int f_up = ( entry_ >> 4 ) & 7;
+	int f_down = ( entry_ >> 7 ) & 7;
+	info_.f1 = up_ ? f_up : f_down;
+	info_.f2 = up_ ? f_down : f_up;
+	info_.gap = entry_ >> 10;
+}
+
+void BitBoard::lookup( int x_, int y_, int dir_, int who_, PosInfo& info_ ) const
+//-------------------------------------------------------------------------------
+{
+	int l = line( x_, y_, dir_ );
+	uint32_t b = 1u << bit( x_, y_, dir_ );
+	uint32_t own = _lines[who_][dir_][l] & ~b;
+	uint32_t empty = _valid[dir_][l] & ~( _lines[1][dir_][l] | _lines[2][dir_][l] | b );
+	unpack( _table[window( own, empty, bit( x_, y_, dir_ ) )], dir_ != 3, info_ );
+}
+
+void BitBoard::lookupPos( int x_, int y_, int who_, Eval& pos_ ) const
+//-------------------------------------------------------------------------------
+{
+	int l1 = y_;
+	int l2 = x_;
+	int l3 = x_ - y_ + _BS;
+	int l4 = x_ + y_;
+#ifdef HAVE_V4
+	int opp = 3 - who_;
+	V4 b = { 1u << x_, 1u << y_, 1u << x_, 1u << x_ };
+	V4 own = { _lines[who_][1][l1], _lines[who_][2][l2], _lines[who_][3][l3], _lines[who_][4][l4] };
+	V4 other = { _lines[opp][1][l1], _lines[opp][2][l2], _lines[opp][3][l3], _lines[opp][4][l4] };
+	V4 valid = { _valid[1][l1], _valid[2][l2], _valid[3][l3], _valid[4][l4] };
+	V4 empty = valid & ~( own | other | b );
+	own &= ~b;
+	unpack( _table[window( own[0], empty[0], x_ )], true, pos_.info[1] );
+	unpack( _table[window( own[1], empty[1], y_ )], true, pos_.info[2] );
+	unpack( _table[window( own[2], empty[2], x_ )], false, pos_.info[3] );
+	unpack( _table[window( own[3], empty[3], x_ )], true, pos_.info[4] );
+#else
+	(void)l1; (void)l2; (void)l3; (void)l4;
+	for ( int dir = 1; dir <= 4; dir++ )
+		lookup( x_, y_, dir, who_, pos_.info[dir] );
+#endif
+}
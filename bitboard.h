@@ -0,0 +1,71 @@
+/*
+
+ FLTK Gomoku - bitboard line counting
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include <cstddef>
+
+struct PosInfo;
+struct Eval;
+
+//-------------------------------------------------------------------------------
+class BitBoard
+//-------------------------------------------------------------------------------
+{
+	// Alternate board representation: for each colour one bit mask per row,
+	// column and diagonal (bit = position in the line). Gives the same
+	// results as ::count(), but with shifts and bit scans instead of
+	// walking the board cell by cell.
+	// Alternatively the counts can be looked up in a table that is indexed
+	// by the WINDOW cells on each side of the cell (3^10 patterns, built on
+	// first use). This gives the same patterns as ::count(), but the number
+	// of freedoms is limited to the window.
+public:
+	enum { WINDOW = 5 };
+	BitBoard( int size_ = 19 );
+	void clear( int size_ );
+	void set( int x_, int y_, int who_ );
+	void remove( int x_, int y_, int who_ );
+	// like ::count() with a piece of who_ at x_/y_ (which must be empty
+	// or who_) for direction dir_ as used in Eval::info[1..4]
+	void count( int x_, int y_, int dir_, int who_, PosInfo& info_ ) const;
+	// all four directions at once
+	void countPos( int x_, int y_, int who_, Eval& pos_ ) const;
+	// the same by table lookup
+	void lookup( int x_, int y_, int dir_, int who_, PosInfo& info_ ) const;
+	void lookupPos( int x_, int y_, int who_, Eval& pos_ ) const;
+	// size in bytes and build time in seconds of the pattern table
+	static size_t tableSize();
+	static double tableTime();
+private:
+	static void countLine( uint32_t own_, uint32_t empty_, int pos_, bool up_, PosInfo& info_ );
+	int line( int x_, int y_, int dir_ ) const;
+	static int bit( int x_, int y_, int dir_ ) { return dir_ == 2 ? y_ : x_; }
+	static const uint16_t *patternTable();
+	static int window( uint32_t own_, uint32_t empty_, int pos_ );
+	static void unpack( uint16_t entry_, bool up_, PosInfo& info_ );
+private:
+	int _BS;
+	uint32_t _lines[2 + 1][4 + 1][48]; // [who][dir][line]
+	uint32_t _valid[4 + 1][48];        // cells of the line on the board
+	const uint16_t *_table;
+};
+
+#endif // BITBOARD_H
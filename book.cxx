@@ -0,0 +1,139 @@
+/*
+
+ FLTK Gomoku - opening book
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "book.h"
+#include "engine.h"
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+
+using namespace std;
+
+static const char MAGIC[8] = { 'G', 'M', 'K', 'B', 'O', 'O', 'K', '1' };
+
+// results of a move as weight for the choice (wins count double)
+static unsigned score( const Book::Entry& e_ )
+{
+	return 2 * e_.wins + e_.draws;
+}
+
+Book::Book() :
+	_header( 0 ),
+	_entries( 0 ),
+	_count( 0 )
+//-------------------------------------------------------------------------------
+{
+}
+
+Book::~Book()
+//-------------------------------------------------------------------------------
+{
+	close();
+}
+
+void Book::close()
+//-------------------------------------------------------------------------------
+{
+	_file.close();
+	_header = 0;
+	_entries = 0;
+	_count = 0;
+}
+
+bool Book::load( const string& file_ )
+//-------------------------------------------------------------------------------
+{
+	close();
+	_file.open( file_ );
+	const char *data = _file.data();
+	size_t bytes = _file.size();
+	const Header *header = reinterpret_cast<const Header *>( data );
+	if ( !data || bytes < sizeof( Header ) || memcmp( header->magic, MAGIC, sizeof( MAGIC ) ) ||
+	     bytes != sizeof( Header ) + header->count * sizeof( Entry ) )
+	{
+		close();
+		return false;
+	}
+	_header = header;
+	_entries = reinterpret_cast<const Entry *>( data + sizeof( Header ) );
+	_count = header->count;
+	return true;
+}
+
+int Book::size() const
+//-------------------------------------------------------------------------------
+{
+	return _header ? _header->size : 0;
+}
+
+int Book::plies() const
+//-------------------------------------------------------------------------------
+{
+	return _header ? _header->plies : 0;
+}
+
+bool Book::probe( const Engine& engine_, int who_, Move& move_, Random& rng_ ) const
+//-------------------------------------------------------------------------------
+{
+	if ( !_count || engine_.size() != size() || engine_.pieces() >= plies() )
+		return false;
+	int sym;
+	uint64_t key = engine_.canonicalKey( who_, sym );
+	const Entry *end = _entries + _count;
+	const Entry *first = lower_bound( _entries, end, key,
+		[]( const Entry& e_, uint64_t key_ ) { return e_.key < key_; } );
+	unsigned total = 0;
+	const Entry *last = first;
+	for ( ; last < end && last->key == key; ++last )
+		total += score( *last );
+	if ( !total )
+		return false; // unknown, or only lost games
+	unsigned r = rng_( total );
+	const Entry *e = first;
+	while ( r >= score( *e ) )
+		r -= score( *e++ );
+	int x = e->x;
+	int y = e->y;
+	engine_.inverseSymmetry( sym, x, y );
+	if ( x < 1 || x > engine_.size() || y < 1 || y > engine_.size() || engine_.at( x, y ) )
+		return false; // (key collision)
+	move_.init( x, y );
+	move_.value = engine_.eval( move_, who_ );
+	return true;
+}
+
+bool Book::write( const string& file_, vector<Entry>& entries_, int size_, int plies_ )
+//-------------------------------------------------------------------------------
+{
+	sort( entries_.begin(), entries_.end(), []( const Entry& a_, const Entry& b_ )
+	{
+		return a_.key != b_.key ? a_.key < b_.key : a_.x != b_.x ? a_.x < b_.x : a_.y < b_.y;
+	} );
+	ofstream ofs( file_.c_str(), ios::binary );
+	if ( !ofs.is_open() )
+		return false;
+	Header header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+	header.size = size_;
+	header.plies = plies_;
+	header.count = entries_.size();
+	ofs.write( reinterpret_cast<const char *>( &header ), sizeof( header ) );
+	ofs.write( reinterpret_cast<const char *>( entries_.data() ), entries_.size() * sizeof( Entry ) );
+	return ofs.good();
+}
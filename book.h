@@ -0,0 +1,85 @@
+/*
+
+ FLTK Gomoku - opening book
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+
+class Engine;
+class Random;
+struct Move;
+
+//-------------------------------------------------------------------------------
+class Book
+//-------------------------------------------------------------------------------
+{
+	// Opening book: the moves played in (self-play) games with their results,
+	// in a sorted binary file that is mapped into memory (no copy, no parsing).
+	// Positions are keyed by Engine::canonicalKey() (colour to move as
+	// colour 1, smallest key of the 8 symmetric positions), the moves are
+	// stored in the orientation of that key.
+	//
+	// File layout (native byte order):
+	//   Header  magic "GMKBOOK1", board size, max. plies, number of entries
+	//   Entry[] sorted by key (then move)
+public:
+	struct Header
+	{
+		char magic[8];
+		uint32_t size;
+		uint32_t plies; // positions with less pieces are in the book
+		uint64_t count;
+	};
+	struct Entry
+	{
+		uint64_t key;
+		uint8_t x;
+		uint8_t y;
+		uint16_t games;
+		uint16_t wins; // of the colour making the move
+		uint16_t draws;
+	};
+	Book();
+	~Book();
+	bool load( const std::string& file_ );
+	void close();
+	bool loaded() const { return _count != 0; }
+	size_t entries() const { return _count; }
+	int size() const;
+	int plies() const;
+	// book move for who_ in the position of engine_, chosen at random
+	// weighted by its results (false if none)
+	bool probe( const Engine& engine_, int who_, Move& move_, Random& rng_ ) const;
+	// write entries_ (sorted here) as book file
+	static bool write( const std::string& file_, std::vector<Entry>& entries_, int size_, int plies_ );
+private:
+	Book( const Book& ); // (shared by the engines via shared_ptr)
+	Book& operator=( const Book& );
+private:
+	MappedFile _file;
+	const Header *_header;
+	const Entry *_entries;
+	size_t _count;
+};
+
+#endif // BOOK_H
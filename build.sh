@@ -5,9 +5,9 @@
 FLTK_CONFIG="$FLTK"fltk-config
 
 TARGET=fltk-gomoku
-SRC=fltk-gomoku.cxx
+SRC="fltk-gomoku.cxx engine.cxx bitboard.cxx mappedfile.cxx book.cxx egdb.cxx gamefile.cxx"
 if [ -f miniaudio.h ]; then
 OPT=-DUSE_MINIAUDIO
 fi
 
-g++ -Wall $OPT -o $TARGET `$FLTK_CONFIG --use-images --cxxflags` $SRC `$FLTK_CONFIG --use-images --ldflags`
+g++ -Wall -pthread $OPT -o $TARGET `$FLTK_CONFIG --use-images --cxxflags` $SRC `$FLTK_CONFIG --use-images --ldflags`
@@ -0,0 +1,155 @@
+/*
+
+ FLTK Gomoku - endgame database
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "egdb.h"
+#include "engine.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+
+using namespace std;
+
+static const char MAGIC[8] = { 'G', 'M', 'K', 'E', 'G', 'D', 'B', '1' };
+static const uint64_t KEY_MASK = ~0xffffULL;
+
+EndgameDB::EndgameDB() :
+	_header( 0 ),
+	_entries( 0 ),
+	_count( 0 )
+//-------------------------------------------------------------------------------
+{
+}
+
+EndgameDB::~EndgameDB()
+//-------------------------------------------------------------------------------
+{
+	close();
+}
+
+void EndgameDB::close()
+//-------------------------------------------------------------------------------
+{
+	_file.close();
+	_header = 0;
+	_entries = 0;
+	_count = 0;
+}
+
+bool EndgameDB::load( const string& file_ )
+//-------------------------------------------------------------------------------
+{
+	close();
+	_file.open( file_ );
+	const char *data = _file.data();
+	size_t bytes = _file.size();
+	const Header *header = reinterpret_cast<const Header *>( data );
+	if ( !data || bytes < sizeof( Header ) || memcmp( header->magic, MAGIC, sizeof( MAGIC ) ) ||
+	     bytes != sizeof( Header ) + header->count * sizeof( uint64_t ) )
+	{
+		close();
+		return false;
+	}
+	_header = header;
+	_entries = reinterpret_cast<const uint64_t *>( data + sizeof( Header ) );
+	_count = header->count;
+	return true;
+}
+
+int EndgameDB::size() const
+//-------------------------------------------------------------------------------
+{
+	return _header ? _header->size : 0;
+}
+
+int EndgameDB::empty() const
+//-------------------------------------------------------------------------------
+{
+	return _header ? _header->empty : 0;
+}
+
+uint64_t EndgameDB::entry( uint64_t key_, Result result_, int x_, int y_ )
+//-------------------------------------------------------------------------------
+{
+	return ( key_ & KEY_MASK ) | (uint64_t)result_ << 10 | x_ << 5 | y_;
+}
+
+EndgameDB::Result EndgameDB::probe( const Engine& engine_, int who_, Move& move_ ) const
+//-------------------------------------------------------------------------------
+{
+	if ( !_count || engine_.size() != size() )
+		return R_Unknown;
+	int sym;
+	uint64_t key = engine_.canonicalKey( who_, sym ) & KEY_MASK;
+	const uint64_t *end = _entries + _count;
+	const uint64_t *e = lower_bound( _entries, end, key );
+	if ( e == end || ( *e & KEY_MASK ) != key )
+		return R_Unknown;
+	int x = ( *e >> 5 ) & 31;
+	int y = *e & 31;
+	engine_.inverseSymmetry( sym, x, y );
+	if ( x < 1 || x > engine_.size() || y < 1 || y > engine_.size() || engine_.at( x, y ) )
+		return R_Unknown; // (key collision)
+	move_.init( x, y );
+	move_.value = engine_.eval( move_, who_ );
+	return result( *e );
+}
+
+bool EndgameDB::check( string& error_ ) const
+//-------------------------------------------------------------------------------
+{
+	ostringstream os;
+	int BS = size();
+	if ( BS < 5 || BS > Engine::BS_Max )
+		os << "invalid board size " << BS;
+	for ( size_t i = 0; i < _count && os.str().empty(); i++ )
+	{
+		uint64_t e = _entries[i];
+		int x = ( e >> 5 ) & 31;
+		int y = e & 31;
+		if ( i && ( _entries[i - 1] & KEY_MASK ) >= ( e & KEY_MASK ) )
+			os << "entry " << i << ": not sorted or duplicate key";
+		else if ( result( e ) == R_Unknown || ( e & 0xf000 ) )
+			os << "entry " << i << ": invalid result";
+		else if ( x < 1 || x > BS || y < 1 || y > BS )
+			os << "entry " << i << ": invalid move";
+	}
+	error_ = os.str();
+	return error_.empty();
+}
+
+bool EndgameDB::write( const string& file_, vector<uint64_t>& entries_, int size_, int empty_ )
+//-------------------------------------------------------------------------------
+{
+	// (only one entry per key)
+	sort( entries_.begin(), entries_.end() );
+	entries_.erase( unique( entries_.begin(), entries_.end(), []( uint64_t a_, uint64_t b_ )
+		{ return ( a_ & KEY_MASK ) == ( b_ & KEY_MASK ); } ), entries_.end() );
+	ofstream ofs( file_.c_str(), ios::binary );
+	if ( !ofs.is_open() )
+		return false;
+	Header header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+	header.size = size_;
+	header.empty = empty_;
+	header.count = entries_.size();
+	ofs.write( reinterpret_cast<const char *>( &header ), sizeof( header ) );
+	ofs.write( reinterpret_cast<const char *>( entries_.data() ), entries_.size() * sizeof( uint64_t ) );
+	return ofs.good();
+}
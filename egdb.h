@@ -0,0 +1,86 @@
+/*
+
+ FLTK Gomoku - endgame database
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#ifndef EGDB_H
+#define EGDB_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+
+class Engine;
+struct Move;
+
+//-------------------------------------------------------------------------------
+class EndgameDB
+//-------------------------------------------------------------------------------
+{
+	// Proven results of positions (built offline by gomoku-egdb, meant for
+	// the small board): forced wins found by a deep threat search, and
+	// exact results of positions with few empty cells. The file is mapped
+	// into memory. Positions are keyed by Engine::canonicalKey(), the moves
+	// are stored in the orientation of that key.
+	//
+	// File layout (native byte order):
+	//   Header  magic "GMKEGDB1", board size, max. empty cells solved
+	//           exactly, number of entries (24 bytes)
+	//   Entry[] one 64 bit word per position, sorted:
+	//           bits 63..16 upper 48 bits of the key
+	//           bits 11..10 result for the side to move (Result)
+	//           bits  9..5  x of the move, bits 4..0 y of the move
+public:
+	enum Result { R_Unknown, R_Win, R_Loss, R_Draw };
+	struct Header
+	{
+		char magic[8];
+		uint32_t size;
+		uint32_t empty;
+		uint64_t count;
+	};
+	EndgameDB();
+	~EndgameDB();
+	bool load( const std::string& file_ );
+	void close();
+	bool loaded() const { return _count != 0; }
+	size_t entries() const { return _count; }
+	int size() const;
+	int empty() const;
+	// result for who_ in the position of engine_ and the move to play
+	// (a winning move, a drawing move or any move of a lost position)
+	Result probe( const Engine& engine_, int who_, Move& move_ ) const;
+	// entry of a position (key_ = Engine::canonicalKey()), move in the
+	// orientation of the key
+	static uint64_t entry( uint64_t key_, Result result_, int x_, int y_ );
+	static Result result( uint64_t entry_ ) { return (Result)( ( entry_ >> 10 ) & 3 ); }
+	// check the structure (sorted, unique keys, valid results and moves)
+	bool check( std::string& error_ ) const;
+	// write entries_ (sorted and made unique here) as database file
+	static bool write( const std::string& file_, std::vector<uint64_t>& entries_, int size_, int empty_ );
+private:
+	EndgameDB( const EndgameDB& ); // (shared by the engines via shared_ptr)
+	EndgameDB& operator=( const EndgameDB& );
+private:
+	MappedFile _file;
+	const Header *_header;
+	const uint64_t *_entries;
+	size_t _count;
+};
+
+#endif // EGDB_H
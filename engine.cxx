@@ -0,0 +1,1599 @@
+/*
+
+ FLTK Gomoku - move engine
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include "book.h"
+#include "egdb.h"
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+#define DBG(a) { if ( _debug ) *_logStream << a << endl; }
+
+// directions used for Eval::info[1..4]
+static const int DIR[4 + 1][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { -1, -1 }, { 1, -1 } };
+
+// search score of a won position (reduced by the ply it is reached at)
+static const int WIN = Engine::WIN_SCORE;
+static const int INF = WIN + 1;
+
+// Zobrist keys for each colour and cell
+static uint64_t ZOBRIST[2 + 1][24][24];
+
+static uint64_t splitmix64( uint64_t& state_ )
+//-------------------------------------------------------------------------------
+{
+	uint64_t z = ( state_ += 0x9e3779b97f4a7c15ULL );
+	z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+	z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+	return z ^ ( z >> 31 );
+}
+
+static bool initZobrist()
+//-------------------------------------------------------------------------------
+{
+	uint64_t state = 20170101; // fixed, so keys are the same in every run
+	for ( int who = 0; who <= 2; who++ )
+		for ( int x = 0; x < 24; x++ )
+			for ( int y = 0; y < 24; y++ )
+				ZOBRIST[who][x][y] = who ? splitmix64( state ) : 0;
+	return true;
+}
+
+static const bool zobristInitialized = initZobrist();
+
+static double now()
+//-------------------------------------------------------------------------------
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+Move::Move( const string& s_ )
+//-------------------------------------------------------------------------------
+{
+	init();
+	if ( ( s_.size() == 2 && s_[0] != '#' ) || ( s_.size() == 3 && s_[0] == '#' ) )
+	{
+		char X = s_[0] == '#' ? s_[2] : s_[1];
+		char Y = s_[0] == '#' ? s_[1] : s_[0];
+		x = X - 'a' + 1;
+		y = Y - 'A' + 1;
+	}
+}
+
+string Move::asString() const
+//-------------------------------------------------------------------------------
+{
+	ostringstream os;
+	os << "#" << (char)( y + 'A' - 1 ) << (char)( x + 'a' - 1 );
+	return os.str();
+}
+
+/*virtual*/
+std::ostream& Move::printOn( std::ostream& os_ ) const
+//-------------------------------------------------------------------------------
+{
+	os_ << asString() << " (" << x << "/" << y << ") value: " << value;
+	return os_;
+}
+
+std::ostream& operator<<( std::ostream &os_, const Move &m_ )
+{
+	return m_.printOn( os_ );
+}
+
+int count( int x_, int y_, int dx_, int dy_, PosInfo &info_,
+           const Board &board_ )
+//-------------------------------------------------------------------------------
+{
+	info_.init();
+	int c = board_[x_][y_];
+	if ( c <= 0 )
+		return 0;
+
+	// count total pieces in row
+	info_.n = 1;
+	int x = x_ + dx_;
+	int y = y_ + dy_;
+	while ( board_[x][y] == c )
+	{
+		info_.n++;
+		x += dx_;
+		y += dy_;
+	}
+	// one side end position after row (not c)
+	int e1x = x;
+	int e1y = y;
+
+	x = x_ - dx_;
+	y = y_ - dy_;
+	while ( board_[x][y] == c )
+	{
+		info_.n++;
+		x -= dx_;
+		y -= dy_;
+	}
+	// if five or more everything else is unimportant
+	if ( info_.n >= 5 )
+		return info_.n;
+
+	// count freedoms and same color in each direction
+	while ( board_[x][y] == 0 )
+	{
+		info_.f2++;
+		x -= dx_;
+		y -= dy_;
+	}
+	int n2 = 0;
+	while ( board_[x][y] == c )
+	{
+		n2++;
+		x -= dx_;
+		y -= dy_;
+	}
+
+	x = e1x;
+	y = e1y;
+
+	while ( board_[x][y] == 0 )
+	{
+		info_.f1++;
+		x += dx_;
+		y += dy_;
+	}
+	int n1 = 0;
+	while ( board_[x][y] == c )
+	{
+		n1++;
+		x += dx_;
+		y += dy_;
+	}
+
+	//  n1  f1   n    f2   n2
+	//  o o . . o o o . . o o
+	int n = info_.n;
+	if ( info_.f1 == 1 ) // gap of 1
+	{
+		int t = info_.n + 1 + n1;
+		if ( t <= 5 )
+			n = info_.n + n1;
+	}
+	if ( info_.f2 == 1 ) // gap of 1
+	{
+		int t = info_.n + 1 + n2;
+		if ( t <= 5 && t > n )
+			n = info_.n + n2;
+	}
+
+	info_.gap = n != info_.n ? 1 : 0;
+	info_.n = n;
+
+	return info_.n;
+} // count
+
+void Random::seed( uint64_t seed_ )
+//-------------------------------------------------------------------------------
+{
+	for ( int i = 0; i < 4; i++ )
+		_s[i] = splitmix64( seed_ );
+}
+
+static inline uint64_t rotl( uint64_t x_, int k_ )
+{
+	return ( x_ << k_ ) | ( x_ >> ( 64 - k_ ) );
+}
+
+uint64_t Random::next()
+//-------------------------------------------------------------------------------
+{
+	uint64_t result = rotl( _s[1] * 5, 7 ) * 9;
+	uint64_t t = _s[1] << 17;
+	_s[2] ^= _s[0];
+	_s[3] ^= _s[1];
+	_s[1] ^= _s[2];
+	_s[0] ^= _s[3];
+	_s[2] ^= t;
+	_s[3] = rotl( _s[3], 45 );
+	return result;
+}
+
+void Random::jump()
+//-------------------------------------------------------------------------------
+{
+	static const uint64_t JUMP[4] =
+		{ 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+	uint64_t s[4] = { 0, 0, 0, 0 };
+	for ( int i = 0; i < 4; i++ )
+	{
+		for ( int b = 0; b < 64; b++ )
+		{
+			if ( JUMP[i] & ( 1ULL << b ) )
+				for ( int j = 0; j < 4; j++ )
+					s[j] ^= _s[j];
+			next();
+		}
+	}
+	for ( int j = 0; j < 4; j++ )
+		_s[j] = s[j];
+}
+
+TimeControl::TimeControl( Mode mode_/* = TC_Move*/, double time_/* = 1*/, double increment_/* = 0*/ ) :
+	_mode( mode_ ),
+	_time( time_ ),
+	_increment( increment_ ),
+	_remaining( time_ )
+//-------------------------------------------------------------------------------
+{
+}
+
+bool TimeControl::parse( const string& s_ )
+//-------------------------------------------------------------------------------
+{
+	char *end;
+	double time = strtod( s_.c_str(), &end );
+	double increment = 0;
+	if ( *end == '+' )
+		increment = strtod( end + 1, &end );
+	if ( *end || end == s_.c_str() || time <= 0 || increment < 0 )
+		return false;
+	_mode = s_.find( '+' ) != string::npos ? TC_Increment : TC_SuddenDeath;
+	_time = time;
+	_increment = increment;
+	reset();
+	return true;
+}
+
+double TimeControl::budget( int pieces_, int size_ ) const
+//-------------------------------------------------------------------------------
+{
+	if ( _mode == TC_Move )
+		return _time;
+	// Spread the clock over the moves still to play: a game rarely fills
+	// more than a quarter of the board, but always reserve time for some
+	// more moves. The opening needs little time, most goes to the middle game.
+	int moves = ( size_ * size_ / 4 - pieces_ ) / 2;
+	if ( moves < 10 )
+		moves = 10;
+	double t = _remaining / moves;
+	if ( pieces_ < 6 )
+		t /= 2;
+	else if ( pieces_ < 40 )
+		t *= 1.5;
+	if ( _mode == TC_Increment )
+		t += 0.8 * _increment;
+	// never more than a part of the clock (with a margin for the overhead)
+	double max = _remaining * ( _mode == TC_Increment ? 0.5 : 0.25 ) - 0.02;
+	if ( t > max )
+		t = max;
+	return t < 0.005 ? 0.005 : t;
+}
+
+void TimeControl::used( double seconds_ )
+//-------------------------------------------------------------------------------
+{
+	if ( _mode == TC_Move )
+		return;
+	_remaining -= seconds_;
+	if ( _remaining > 0 && _mode == TC_Increment )
+		_remaining += _increment;
+}
+
+string TimeControl::format( double seconds_ )
+//-------------------------------------------------------------------------------
+{
+	if ( seconds_ < 0 )
+		seconds_ = 0;
+	char buf[32];
+	if ( seconds_ < 10 )
+		snprintf( buf, sizeof( buf ), "%.1f", seconds_ );
+	else
+	{
+		int s = (int)seconds_;
+		snprintf( buf, sizeof( buf ), "%d:%02d", s / 60, s % 60 );
+	}
+	return buf;
+}
+
+static const struct
+{
+	const char *name;
+	int Weights::*value;
+} WEIGHTS[Weights::W_Count] =
+{
+	{ "win", &Weights::win },
+	{ "four", &Weights::four },
+	{ "fork", &Weights::fork },
+	{ "three_open", &Weights::threeOpen },
+	{ "three", &Weights::three },
+	{ "two", &Weights::two },
+	{ "win_factor", &Weights::winFactor },
+	{ "own_bonus", &Weights::ownBonus }
+};
+
+int& Weights::operator[]( int i_ )
+//-------------------------------------------------------------------------------
+{
+	return this->*WEIGHTS[i_].value;
+}
+
+const char *Weights::name( int i_ )
+//-------------------------------------------------------------------------------
+{
+	return WEIGHTS[i_].name;
+}
+
+bool Weights::load( const string& file_ )
+//-------------------------------------------------------------------------------
+{
+	// weights not in the file keep their value, '#' starts a comment
+	ifstream ifs( file_.c_str() );
+	if ( !ifs.is_open() )
+		return false;
+	Weights w( *this );
+	string line;
+	while ( getline( ifs, line ) )
+	{
+		istringstream is( line.substr( 0, line.find( '#' ) ) );
+		string name;
+		int value;
+		if ( !( is >> name ) )
+			continue;
+		int i = 0;
+		while ( i < W_Count && name != WEIGHTS[i].name )
+			i++;
+		if ( i == W_Count || !( is >> value ) || value < 0 )
+			return false;
+		w[i] = value;
+	}
+	*this = w;
+	return true;
+}
+
+bool Weights::save( const string& file_ ) const
+//-------------------------------------------------------------------------------
+{
+	ofstream ofs( file_.c_str() );
+	for ( int i = 0; i < W_Count && ofs.is_open(); i++ )
+		ofs << WEIGHTS[i].name << " " << (*this)[i] << endl;
+	return ofs.good();
+}
+
+TransTable::TransTable( size_t mb_/* = 16*/ ) :
+	_size( 0 ),
+	_probes( 0 ),
+	_hits( 0 )
+//-------------------------------------------------------------------------------
+{
+	resize( mb_ );
+}
+
+void TransTable::resize( size_t mb_ )
+//-------------------------------------------------------------------------------
+{
+	// use the largest power of two number of slots that fits
+	size_t slots = 1;
+	while ( slots * 2 * sizeof( Slot ) <= ( mb_ ? mb_ : 1 ) * 1024 * 1024 )
+		slots *= 2;
+	_slots.reset( new Slot[slots] );
+	_size = slots;
+	clear();
+}
+
+void TransTable::clear()
+//-------------------------------------------------------------------------------
+{
+	for ( size_t i = 0; i < _size; i++ )
+	{
+		_slots[i].key.store( 0, std::memory_order_relaxed );
+		_slots[i].data.store( 0, std::memory_order_relaxed );
+	}
+	resetStats();
+}
+
+// data layout: score (32 bits), depth (8), bound (2), x (5), y (5)
+bool TransTable::probe( uint64_t key_, Entry& entry_ ) const
+//-------------------------------------------------------------------------------
+{
+	_probes.fetch_add( 1, std::memory_order_relaxed );
+	const Slot& slot = _slots[key_ & ( _size - 1 )];
+	uint64_t data = slot.data.load( std::memory_order_relaxed );
+	uint64_t key = slot.key.load( std::memory_order_relaxed );
+	if ( ( key ^ data ) != key_ || !data )
+		return false;
+	_hits.fetch_add( 1, std::memory_order_relaxed );
+	entry_.score = (int32_t)( data & 0xffffffff );
+	entry_.depth = ( data >> 32 ) & 0xff;
+	entry_.bound = (Bound)( ( data >> 40 ) & 3 );
+	entry_.x = ( data >> 42 ) & 31;
+	entry_.y = ( data >> 47 ) & 31;
+	return true;
+}
+
+void TransTable::store( uint64_t key_, const Entry& entry_ )
+//-------------------------------------------------------------------------------
+{
+	Slot& slot = _slots[key_ & ( _size - 1 )];
+	uint64_t old_data = slot.data.load( std::memory_order_relaxed );
+	uint64_t old_key = slot.key.load( std::memory_order_relaxed ) ^ old_data;
+	// keep deeper results of the same position
+	if ( old_key == key_ && (int)( ( old_data >> 32 ) & 0xff ) > entry_.depth )
+		return;
+	uint64_t data = (uint64_t)(uint32_t)entry_.score |
+	                (uint64_t)( entry_.depth & 0xff ) << 32 |
+	                (uint64_t)( entry_.bound & 3 ) << 40 |
+	                (uint64_t)( entry_.x & 31 ) << 42 |
+	                (uint64_t)( entry_.y & 31 ) << 47;
+	slot.key.store( key_ ^ data, std::memory_order_relaxed );
+	slot.data.store( data, std::memory_order_relaxed );
+}
+
+Engine::Engine( int size_/* = BS_Standard*/ ) :
+	_BS( size_ ),
+	_counter( CT_Table ),
+	_tt( std::make_shared<TransTable>() ),
+	_searchTime( 0 ),
+	_searchDepth( 12 ),
+	_searchWidth( 10 ),
+	_vcfDepth( 16 ),
+	_vctDepth( 5 ),
+	_threatNodes( 0 ),
+	_threatLimit( 20000 ),
+	_threads( 1 ),
+	_helper( 0 ),
+	_abort( 0 ),
+	_nodes( 0 ),
+	_depth( 0 ),
+	_score( 0 ),
+	_stop( false ),
+	_deadline( 0 ),
+	_debug( 0 ),
+	_logStream( &std::cout )
+//-------------------------------------------------------------------------------
+{
+	clearBoard();
+}
+
+void Engine::size( int size_ )
+//-------------------------------------------------------------------------------
+{
+	_BS = size_;
+	clearBoard();
+}
+
+void Engine::clearBoard()
+//-------------------------------------------------------------------------------
+{
+	memset( _board, -1, sizeof( _board ) );
+	for ( int x = 1; x <= _BS; x++ )
+		for ( int y = 1; y <= _BS; y++ )
+			_board[x][y] = 0;
+	memset( _symKey, 0, sizeof( _symKey ) );
+	_bits.clear( _BS );
+	_candCount = 0;
+	_pieces = 0;
+	memset( _candIndex, -1, sizeof( _candIndex ) );
+	memset( _near, 0, sizeof( _near ) );
+	initEval();
+}
+
+void Engine::setPiece( int x_, int y_, int who_ )
+//-------------------------------------------------------------------------------
+{
+	account( x_, y_, -1 ); // cell is no longer a candidate
+	_board[x_][y_] = who_;
+	updateKeys( x_, y_, who_ );
+	_bits.set( x_, y_, who_ );
+	updateCandidates( x_, y_, 1 );
+	updateEval( x_, y_ );
+}
+
+void Engine::removePiece( int x_, int y_ )
+//-------------------------------------------------------------------------------
+{
+	updateKeys( x_, y_, _board[x_][y_] );
+	_bits.remove( x_, y_, _board[x_][y_] );
+	_board[x_][y_] = 0;
+	updateCandidates( x_, y_, -1 );
+	for ( int dir = 1; dir <= 4; dir++ )
+		countEval( x_, y_, dir );
+	account( x_, y_, 1 );
+	updateEval( x_, y_ );
+}
+
+void Engine::updateKeys( int x_, int y_, int who_ )
+//-------------------------------------------------------------------------------
+{
+	// add/remove a piece of who_ at x_/y_ to/from the symmetric keys
+	for ( int sym = 0; sym < 8; sym++ )
+	{
+		int x = x_;
+		int y = y_;
+		symmetry( sym, x, y );
+		_symKey[0][sym] ^= ZOBRIST[who_][x][y];
+		_symKey[1][sym] ^= ZOBRIST[3 - who_][x][y];
+	}
+}
+
+void Engine::counter( Counter counter_ )
+//-------------------------------------------------------------------------------
+{
+	_counter = counter_;
+	recountEval();
+}
+
+void Engine::weights( const Weights& weights_ )
+//-------------------------------------------------------------------------------
+{
+	_weights = weights_;
+	recountEval();
+}
+
+void Engine::recountEval()
+//-------------------------------------------------------------------------------
+{
+	// recount the evaluation of all empty cells
+	for ( int x = 1; x <= _BS; x++ )
+		for ( int y = 1; y <= _BS; y++ )
+			if ( _board[x][y] == 0 )
+				for ( int dir = 1; dir <= 4; dir++ )
+					updateEval( x, y, dir );
+}
+
+void Engine::initEval()
+//-------------------------------------------------------------------------------
+{
+	for ( int who = 1; who <= 2; who++ )
+	{
+		_total[who] = 0;
+		_wins[who] = 0;
+		_fours[who] = 0;
+	}
+	for ( int x = 1; x <= _BS; x++ )
+	{
+		for ( int y = 1; y <= _BS; y++ )
+		{
+			for ( int dir = 1; dir <= 4; dir++ )
+				countEval( x, y, dir );
+			account( x, y, 1 );
+		}
+	}
+}
+
+void Engine::updateCandidates( int x_, int y_, int delta_ )
+//-------------------------------------------------------------------------------
+{
+	// piece set (delta_ = 1) or removed (-1) at x_/y_
+	_pieces += delta_;
+	if ( delta_ > 0 )
+		removeCandidate( x_, y_ );
+	else if ( _near[x_][y_] )
+		addCandidate( x_, y_ );
+	for ( int x = x_ - 2; x <= x_ + 2; x++ )
+	{
+		if ( x < 1 || x > _BS )
+			continue;
+		for ( int y = y_ - 2; y <= y_ + 2; y++ )
+		{
+			if ( y < 1 || y > _BS || ( x == x_ && y == y_ ) )
+				continue;
+			_near[x][y] += delta_;
+			if ( _board[x][y] != 0 )
+				continue;
+			if ( delta_ > 0 && _near[x][y] == 1 )
+				addCandidate( x, y );
+			else if ( delta_ < 0 && _near[x][y] == 0 )
+				removeCandidate( x, y );
+		}
+	}
+}
+
+void Engine::addCandidate( int x_, int y_ )
+//-------------------------------------------------------------------------------
+{
+	if ( _candIndex[x_][y_] >= 0 )
+		return;
+	_candIndex[x_][y_] = _candCount;
+	_cand[_candCount++] = x_ << 5 | y_;
+}
+
+void Engine::removeCandidate( int x_, int y_ )
+//-------------------------------------------------------------------------------
+{
+	int i = _candIndex[x_][y_];
+	if ( i < 0 )
+		return;
+	// move last one into the gap
+	int last = _cand[--_candCount];
+	_cand[i] = last;
+	_candIndex[last >> 5][last & 31] = i;
+	_candIndex[x_][y_] = -1;
+}
+
+int Engine::candidates( short *cells_ ) const
+//-------------------------------------------------------------------------------
+{
+	// copy of the candidate list (which changes with every setPiece()/removePiece())
+	memcpy( cells_, _cand, _candCount * sizeof( _cand[0] ) );
+	return _candCount;
+}
+
+void Engine::account( int x_, int y_, int sign_ )
+//-------------------------------------------------------------------------------
+{
+	// (winning cells are only counted in _wins, as one of them can be blocked)
+	for ( int who = 1; who <= 2; who++ )
+	{
+		const Eval& e = _eval[who][x_][y_];
+		if ( e.wins() )
+			_wins[who] += sign_;
+		else
+			_total[who] += sign_ * _value[who][x_][y_];
+		if ( e.has4() )
+			_fours[who] += sign_;
+	}
+}
+
+void Engine::updateEval( int x_, int y_ )
+//-------------------------------------------------------------------------------
+{
+	// A change at x_/y_ can only affect the evaluation of the empty cells
+	// on the four lines through it - and only in the direction of that line.
+	int reach = _counter == CT_Table ? (int)BitBoard::WINDOW : _BS;
+	for ( int dir = 1; dir <= 4; dir++ )
+	{
+		int dx = DIR[dir][0];
+		int dy = DIR[dir][1];
+		int x = x_;
+		int y = y_;
+		int d = 0;
+		while ( d > -reach && _board[x - dx][y - dy] >= 0 )
+		{
+			x -= dx;
+			y -= dy;
+			d--;
+		}
+		for ( ; d <= reach && _board[x][y] >= 0; d++, x += dx, y += dy )
+			updateEval( x, y, dir );
+	}
+}
+
+void Engine::updateEval( int x_, int y_, int dir_ )
+//-------------------------------------------------------------------------------
+{
+	if ( _board[x_][y_] != 0 )
+		return;
+	account( x_, y_, -1 );
+	countEval( x_, y_, dir_ );
+	account( x_, y_, 1 );
+}
+
+void Engine::countEval( int x_, int y_, int dir_ )
+//-------------------------------------------------------------------------------
+{
+	if ( _counter == CT_Table )
+	{
+		for ( int who = 1; who <= 2; who++ )
+		{
+			_bits.lookup( x_, y_, dir_, who, _eval[who][x_][y_].info[dir_] );
+			_value[who][x_][y_] = value( _eval[who][x_][y_] );
+		}
+		return;
+	}
+	if ( _counter == CT_BitBoard )
+	{
+		for ( int who = 1; who <= 2; who++ )
+		{
+			_bits.count( x_, y_, dir_, who, _eval[who][x_][y_].info[dir_] );
+			_value[who][x_][y_] = value( _eval[who][x_][y_] );
+		}
+		return;
+	}
+	// set the piece in place (no board copy), count and restore
+	for ( int who = 1; who <= 2; who++ )
+	{
+		_board[x_][y_] = who;
+		::count( x_, y_, DIR[dir_][0], DIR[dir_][1], _eval[who][x_][y_].info[dir_], _board );
+		_value[who][x_][y_] = value( _eval[who][x_][y_] );
+	}
+	_board[x_][y_] = 0;
+}
+
+bool Engine::loadBoard( istream& is_, int player_, int& lastMoved_, Move& lastMove_ )
+//-------------------------------------------------------------------------------
+{
+	// (replaces the position, so pieces are never set on occupied cells)
+	clearBoard();
+	int computer = 3 - player_;
+	int y = 0;
+	lastMoved_ = 0;
+	lastMove_.init();
+	string line;
+	while ( getline( is_, line ) )
+	{
+		if ( y ) // skip first line (labels)
+		{
+			if ( (int)line.size() < 2 * ( _BS ) + 1 ) break;
+			for ( int x = 1; x <= _BS; x++ )
+			{
+				char c = line[ x * 2];
+				if ( c == 'p' || c == 'P' )
+					setPiece( x, y, player_ );
+				if ( c == 'c' || c == 'C' )
+					setPiece( x, y, computer );
+				if ( c == 'P' || c == 'C' )
+				{
+					lastMove_.init( x, y );
+				}
+				if ( c == 'P' )
+					lastMoved_ = player_;
+				if ( c == 'C' )
+					lastMoved_ = computer;
+			}
+		}
+		if ( ++y > _BS ) break;
+	}
+	return y >= _BS;
+}
+
+std::ostream& Engine::dumpBoard( std::ostream& os_, const Move& lastMove_, int player_ ) const
+//-------------------------------------------------------------------------------
+{
+	os_ << " ";
+	for ( int x = 1; x <= _BS; x++ )
+		os_ << " " << (char)('a' + x - 1);
+	os_ << endl;
+	for ( int y = 1; y <= _BS; y++ )
+	{
+		os_ << (char)('A' + y - 1) << " ";
+		for ( int x = 1; x <= _BS; x++ )
+		{
+			int who = _board[x][y];
+			bool last = x == lastMove_.x && y == lastMove_.y;
+			char player = last ? 'P' : 'p';
+			char computer = last ? 'C' : 'c';
+			os_ << ( who ? ( who == player_ ? player  : computer ) : '.' ) << ' ';
+		}
+		os_ << endl;
+	}
+	os_ << endl;
+	return os_;
+}
+
+std::ostream& Engine::dumpGame( std::ostream& os_, const vector<Move>& moves_, int player_ ) const
+//-------------------------------------------------------------------------------
+{
+	int computer = 3 - player_;
+	for ( size_t i = 0; i < moves_.size(); i++ )
+	{
+		const Move& move = moves_[i];
+		int who = _board[move.x][move.y];
+		if ( who == computer && i == 0 )
+			os_ << "-\t";
+		os_ << move.asString();
+		if ( who == player_ )
+			os_ << "\t";
+		else
+			os_ << endl;
+	}
+	return os_;
+}
+
+void Engine::countPos( int x_, int y_, Eval &pos_, const Board &board_ ) const
+//-------------------------------------------------------------------------------
+{
+	for ( int dir = 1; dir <= 4; dir++ )
+		::count( x_, y_, DIR[dir][0], DIR[dir][1], pos_.info[dir], board_ );
+}
+
+void Engine::countPos( int x_, int y_, Eval &pos_ ) const
+//-------------------------------------------------------------------------------
+{
+	countPos( x_, y_, pos_, _board );
+}
+
+void Engine::countPos( Move& move_, const Board &board_ ) const
+//-------------------------------------------------------------------------------
+{
+	countPos( move_.x, move_.y, move_.eval, board_ );
+}
+
+bool Engine::checkWin( int x_, int y_ ) const
+//-------------------------------------------------------------------------------
+{
+	Eval e;
+	countPos( x_, y_, e );
+	return e.wins();
+}
+
+bool Engine::randomMove( Move& move_ ) const
+//-------------------------------------------------------------------------------
+{
+	// random move, preferably in the center area of the board
+	vector<Move> center;
+	vector<Move> others;
+	int R = _BS / 3;
+	for ( int x = 1; x <= _BS; x++ )
+	{
+		for ( int y = 1; y <= _BS; y++ )
+		{
+			if ( _board[x][y] == 0 )
+			{
+				if ( x > R && x <= _BS - R &&
+				     y > R && y <= _BS - R )
+					center.push_back( Move( x, y ) );
+				else
+					others.push_back( Move( x, y ) );
+			}
+		}
+	}
+	vector<Move>& moves = center.empty() ? others : center;
+	if ( moves.empty() )
+		return false;
+	move_ = moves[_rng( moves.size() )];
+	return true;
+} // randomMove
+
+bool Engine::findMove( Move& move_, int who_ )
+//-------------------------------------------------------------------------------
+{
+	// with a search time the threat search may use half of it
+	// (in greedy mode it is limited by the number of nodes only)
+	double start = now();
+	_deadline = _searchTime > 0 ? start + _searchTime / 2 : 0;
+	_nodes = 0;
+	_depth = 0;
+	_score = 0;
+	if ( _book && _book->probe( *this, who_, move_, _rng ) )
+	{
+		DBG( "book move " << move_ );
+		return true;
+	}
+	if ( _egdb )
+	{
+		// (in a lost position the search looks for the longest resistance)
+		EndgameDB::Result result = _egdb->probe( *this, who_, move_ );
+		if ( result == EndgameDB::R_Win || result == EndgameDB::R_Draw )
+		{
+			_score = result == EndgameDB::R_Win ? WIN - MAX_PLY : 0;
+			DBG( "endgame database " << ( result == EndgameDB::R_Win ? "win " : "draw " ) << move_ );
+			return true;
+		}
+	}
+	// (the greedy mode is for fast moves: only the VCF, as the VCT can
+	// take 100 ms and more to reach its node limit)
+	if ( solve( move_, who_, _searchTime > 0 ) )
+		return true;
+	_deadline = start + _searchTime;
+	if ( _searchTime > 0 )
+		return search( move_, who_ );
+	return greedyMove( move_, who_ );
+}
+
+bool Engine::greedyMove( Move& move_, int who_ ) const
+//-------------------------------------------------------------------------------
+{
+	// collect the moves with the highest value in a single pass
+	// (only one allocation for the candidate list)
+	int evaluated = 0;
+	int max_value = 0;
+	vector<Move> equal;
+	equal.reserve( _candCount );
+	for ( int i = 0; i < _candCount; i++ )
+	{
+		Move move( _cand[i] >> 5, _cand[i] & 31 );
+		int value = eval( move, who_ );
+		if ( !value )
+			continue;
+		evaluated++;
+		if ( value < max_value )
+			continue;
+		if ( value > max_value )
+		{
+			equal.clear();
+			max_value = value;
+		}
+		equal.push_back( move );
+	}
+	DBG( evaluated << " moves evaluated" );
+	if ( equal.empty() )
+		return false;
+
+	DBG( equal.size() << " moves with value " << max_value );
+	for ( size_t i = 0; i < equal.size(); i++ )
+		DBG( "\t" << equal[i] );
+	int move = _rng( equal.size() );
+	move_ = equal[move];
+	return true;
+} // greedyMove
+
+int Engine::value( const Eval& e_ ) const
+//-------------------------------------------------------------------------------
+{
+	int value = 0;
+	if ( e_.wins() )
+		value += _weights.win;
+	if ( e_.has4() )
+		value += e_.has4() * _weights.four;
+	if ( e_.has3Fork() )
+		value += e_.has3Fork() * _weights.fork;
+	if ( e_.has3nogap() )
+		value += e_.has3() * _weights.threeOpen;
+	if ( e_.has3() )
+		value += e_.has3() * _weights.three;
+	if ( e_.has2() )
+		value += e_.has2() * _weights.two;
+	return value;
+}
+
+bool Engine::evalTerms( int who_, int terms_[Weights::W_Count] ) const
+//-------------------------------------------------------------------------------
+{
+	for ( int i = 0; i < Weights::W_Count; i++ )
+		terms_[i] = 0;
+	for ( int x = 1; x <= _BS; x++ )
+	{
+		for ( int y = 1; y <= _BS; y++ )
+		{
+			if ( _board[x][y] )
+				continue;
+			for ( int who = 1; who <= 2; who++ )
+			{
+				const Eval& e = _eval[who][x][y];
+				if ( e.wins() )
+					continue;
+				int sign = who == who_ ? 1 : -1;
+				terms_[Weights::W_Four] += sign * e.has4();
+				terms_[Weights::W_Fork] += sign * e.has3Fork();
+				terms_[Weights::W_ThreeOpen] += e.has3nogap() ? sign * e.has3() : 0;
+				terms_[Weights::W_Three] += sign * e.has3();
+				terms_[Weights::W_Two] += sign * e.has2();
+			}
+		}
+	}
+	return !_wins[1] && !_wins[2] && !_fours[who_];
+}
+
+int Engine::evaluate( Move& m_, int who_ ) const
+//-------------------------------------------------------------------------------
+{
+	// evaluation of the empty cell is kept up to date by setPiece()/removePiece()
+	m_.eval = _eval[who_][m_.x][m_.y];
+	m_.value += value( m_.eval );
+
+	if ( _debug )
+	{
+		if ( m_.eval.wins() )
+			DBG( "eval " << who_ <<  " wins at " << m_ );
+		if ( m_.eval.has4() )
+			DBG( "eval has4 " << who_ << " at " << m_ );
+		if ( m_.eval.has3Fork() )
+			DBG( "eval has3Fork " << who_ << " at " << m_ );
+		if ( m_.eval.has3nogap() )
+			DBG( "eval has3nogap " << who_ << " at " << m_ );
+		if ( m_.eval.has3() )
+			DBG( "eval has3 " << who_ << " at " << m_ );
+		if ( m_.eval.has2() )
+			DBG( "eval has2 " << who_ << " at " << m_ );
+	}
+	return m_.value;
+}
+
+int Engine::eval( Move& move_, int who_ ) const
+//-------------------------------------------------------------------------------
+{
+	// who_ is the side to move, the other one is the opponent
+	Move mc( move_.x, move_.y );
+	evaluate( mc, who_ );
+	if ( mc.eval.wins() )
+		mc.value *= _weights.winFactor; // don't miss winning move!
+	else if ( mc.value ) // always just raise own move above equal opponent move
+		mc.value += _weights.ownBonus;
+
+	Move mp( move_.x, move_.y );
+	evaluate( mp, 3 - who_ );
+
+	move_.value = mc.value + mp.value;
+	if ( move_.value )
+	{
+		DBG( move_ << " (combined)" );
+	}
+	return move_.value;
+} // eval
+
+int Engine::moveValue( int x_, int y_, int who_ ) const
+//-------------------------------------------------------------------------------
+{
+	// same as eval(), but without a Move and logging
+	int value = _value[who_][x_][y_];
+	if ( _eval[who_][x_][y_].wins() )
+		value *= _weights.winFactor;
+	else if ( value )
+		value += _weights.ownBonus;
+	return value + _value[3 - who_][x_][y_];
+}
+
+int Engine::staticValue( int who_ ) const
+//-------------------------------------------------------------------------------
+{
+	// leaf evaluation from the view of the side to move:
+	// the sum of the cell values of both sides (kept by setPiece()/removePiece())
+	int opp = 3 - who_;
+	return _total[who_] - _total[opp];
+}
+
+int Engine::generateMoves( int who_, SearchMove *moves_, bool& win_ ) const
+//-------------------------------------------------------------------------------
+{
+	// Collect all moves with a value sorted by value. If the side to move
+	// can win, return only this move. If the opponent threatens to win,
+	// return only the blocking move(s).
+	int opp = 3 - who_;
+	int n = 0;
+	int blocks = 0;
+	win_ = false;
+	for ( int i = 0; i < _candCount; i++ )
+	{
+		int x = _cand[i] >> 5;
+		int y = _cand[i] & 31;
+		if ( _eval[who_][x][y].wins() )
+		{
+			win_ = true;
+			moves_[0].x = x;
+			moves_[0].y = y;
+			moves_[0].value = moveValue( x, y, who_ );
+			return 1;
+		}
+		if ( _eval[opp][x][y].wins() )
+		{
+			// move block moves to front, discard the others
+			if ( !blocks )
+				n = 0;
+			SearchMove &m = moves_[n++];
+			m.x = x;
+			m.y = y;
+			m.value = moveValue( x, y, who_ );
+			blocks++;
+			continue;
+		}
+		if ( blocks )
+			continue;
+		int value = moveValue( x, y, who_ );
+		if ( !value )
+			continue;
+		SearchMove &m = moves_[n++];
+		m.x = x;
+		m.y = y;
+		m.value = value;
+	}
+	std::sort( moves_, moves_ + n );
+	return n;
+}
+
+bool Engine::timeUp()
+//-------------------------------------------------------------------------------
+{
+	// (checked every 16 nodes: reading the clock is cheap compared to
+	// a node, and the search stops well within a millisecond)
+	if ( !_stop && ( _nodes & 15 ) == 0 && now() > _deadline )
+		_stop = true;
+	if ( _abort && _abort->load( std::memory_order_relaxed ) )
+		_stop = true;
+	return _stop;
+}
+
+int Engine::negamax( int who_, int depth_, int alpha_, int beta_, int ply_ )
+//-------------------------------------------------------------------------------
+{
+	_nodes++;
+	if ( timeUp() )
+		return 0;
+
+	int opp = 3 - who_;
+	if ( _wins[who_] )
+		return WIN - ply_; // can win with next move
+	if ( depth_ <= 0 || ply_ >= MAX_PLY )
+	{
+		if ( _wins[opp] >= 2 )
+			return -( WIN - ply_ - 1 ); // can't block both
+		return staticValue( who_ );
+	}
+
+	// transposition table lookup (the move is stored in the orientation
+	// of the canonical key)
+	int sym;
+	uint64_t key = canonicalKey( who_, sym );
+	TransTable::Entry entry;
+	bool hit = _tt->probe( key, entry );
+	if ( hit )
+		inverseSymmetry( sym, entry.x, entry.y );
+	if ( hit && entry.depth >= depth_ )
+	{
+		// (win/loss scores are stored relative to the node)
+		int score = entry.score;
+		if ( score >= WIN - MAX_PLY )
+			score -= ply_;
+		else if ( score <= -( WIN - MAX_PLY ) )
+			score += ply_;
+		if ( entry.bound == TransTable::TT_Exact ||
+		     ( entry.bound == TransTable::TT_Lower && score >= beta_ ) ||
+		     ( entry.bound == TransTable::TT_Upper && score <= alpha_ ) )
+			return score;
+	}
+
+	SearchMove moves[MAX_MOVES];
+	bool win;
+	int n = generateMoves( who_, moves, win );
+	if ( !n )
+		return staticValue( who_ ); // no more moves (board full or quiet)
+	if ( n > _searchWidth )
+		n = _searchWidth;
+	if ( hit )
+	{
+		// search best move from table first
+		for ( int i = 0; i < n; i++ )
+		{
+			if ( moves[i].x == entry.x && moves[i].y == entry.y )
+			{
+				std::rotate( moves, moves + i, moves + i + 1 );
+				break;
+			}
+		}
+	}
+
+	int alpha = alpha_;
+	int best = -INF;
+	int best_index = 0;
+	for ( int i = 0; i < n; i++ )
+	{
+		setPiece( moves[i].x, moves[i].y, who_ );
+		int score = -negamax( opp, depth_ - 1, -beta_, -alpha, ply_ + 1 );
+		removePiece( moves[i].x, moves[i].y );
+		if ( _stop )
+			return 0;
+		if ( score > best )
+		{
+			best = score;
+			best_index = i;
+			if ( score > alpha )
+				alpha = score;
+			if ( alpha >= beta_ )
+				break;
+		}
+	}
+
+	entry.score = best;
+	if ( best >= WIN - MAX_PLY )
+		entry.score += ply_;
+	else if ( best <= -( WIN - MAX_PLY ) )
+		entry.score -= ply_;
+	entry.depth = depth_;
+	entry.bound = best <= alpha_ ? TransTable::TT_Upper :
+	              best >= beta_ ? TransTable::TT_Lower : TransTable::TT_Exact;
+	entry.x = moves[best_index].x;
+	entry.y = moves[best_index].y;
+	symmetry( sym, entry.x, entry.y );
+	_tt->store( key, entry );
+	return best;
+} // negamax
+
+bool Engine::search( Move& move_, int who_ )
+//-------------------------------------------------------------------------------
+{
+	// negamax alpha-beta search with iterative deepening
+	// until _deadline (set by findMove()).
+	double start = now();
+	_stop = false;
+	_tt->resetStats();
+
+	SearchMove moves[MAX_MOVES];
+	bool win;
+	int n = generateMoves( who_, moves, win );
+	if ( !n )
+		return false;
+
+	// random order for moves of same value
+	for ( int i = n - 1; i > 0; i-- )
+		std::swap( moves[i], moves[_rng( i + 1 )] );
+	std::stable_sort( moves, moves + n );
+
+	SearchMove best = moves[0];
+	_score = win ? WIN : 0;
+	int opp = 3 - who_;
+	if ( !win && n > 1 && _vcfDepth )
+	{
+		// if the opponent has a forced win by fours, keep only moves refuting it
+		_threatNodes = 0;
+		if ( threat( opp, _vcfDepth, false, 1 ) )
+		{
+			int defences = 0;
+			for ( int i = 0; i < n; i++ )
+			{
+				// (the node limit applies to each move on its own)
+				setPiece( moves[i].x, moves[i].y, who_ );
+				_threatNodes = 0;
+				if ( !threat( opp, _vcfDepth, false, 1 ) )
+					moves[defences++] = moves[i];
+				removePiece( moves[i].x, moves[i].y );
+			}
+			DBG( "opponent threatens VCF, " << defences << " defences" );
+			if ( defences )
+				n = defences;
+		}
+	}
+	if ( !win && n > 1 )
+	{
+		if ( n > 2 * _searchWidth )
+			n = 2 * _searchWidth;
+		// Lazy SMP: helper threads search the same root moves on copies of
+		// the engine and share the transposition table. They start at
+		// different depths and in a different order, so the main thread
+		// mostly finds their results in the table. The helpers stop
+		// when the main thread is finished.
+		std::atomic<bool> abort( false );
+		vector<std::unique_ptr<Engine>> helpers;
+		vector<std::thread> threads;
+		for ( int i = 1; i < _threads; i++ )
+		{
+			helpers.emplace_back( new Engine( *this ) );
+			Engine *helper = helpers.back().get();
+			helper->_helper = i;
+			helper->_abort = &abort;
+			helper->_debug = 0;
+			helper->_nodes = 0; // (the copy has the solver's nodes, counted already)
+			for ( int j = 0; j < i; j++ )
+				helper->_rng.jump();
+			threads.emplace_back( [helper, who_, moves, n]()
+			{
+				SearchMove m[MAX_MOVES];
+				std::copy( moves, moves + n, m );
+				if ( helper->_helper % 2 )
+					std::swap( m[0], m[1] );
+				SearchMove best;
+				helper->iterate( who_, m, n, 1 + helper->_helper % 2, best );
+			} );
+		}
+		_score = iterate( who_, moves, n, 1, best );
+		abort = true;
+		for ( size_t i = 0; i < threads.size(); i++ )
+		{
+			threads[i].join();
+			_nodes += helpers[i]->_nodes;
+		}
+	}
+	double elapsed = now() - start;
+	DBG( "search: depth " << _depth << " nodes " << _nodes << " time " << elapsed <<
+	     "s nps " << (long)( _nodes / ( elapsed > 0 ? elapsed : 1e-6 ) ) <<
+	     " threads " << _threads );
+	DBG( "hash: " << _tt->size() << " entries, probes " << _tt->probes() << " hits " << _tt->hits() <<
+	     " (" << ( _tt->probes() ? 100 * _tt->hits() / _tt->probes() : 0 ) << "%)" );
+	move_.init( best.x, best.y, best.value );
+	return true;
+} // search
+
+int Engine::scoreMove( const Move& move_, int who_, int depth_ )
+//-------------------------------------------------------------------------------
+{
+	// (as the first root move of an iteration of iterate())
+	if ( _eval[who_][move_.x][move_.y].wins() )
+		return WIN;
+	_stop = false;
+	_deadline = now() + 1e6;
+	setPiece( move_.x, move_.y, who_ );
+	int score = -negamax( 3 - who_, depth_ - 1, -INF, INF, 1 );
+	removePiece( move_.x, move_.y );
+	return score;
+}
+
+int Engine::iterate( int who_, SearchMove *moves_, int n_, int depth_, SearchMove& best_ )
+//-------------------------------------------------------------------------------
+{
+	// iterative deepening over the root moves from depth_ on,
+	// returns the score of the best move best_
+	double start = now();
+	int opp = 3 - who_;
+	int best_score = 0;
+	best_ = moves_[0];
+	for ( int depth = depth_; depth <= _searchDepth && !_stop; depth++ )
+	{
+		int alpha = -INF;
+		int best_index = -1;
+		for ( int i = 0; i < n_; i++ )
+		{
+			setPiece( moves_[i].x, moves_[i].y, who_ );
+			int score = -negamax( opp, depth - 1, -INF, -alpha, 1 );
+			removePiece( moves_[i].x, moves_[i].y );
+			if ( _stop )
+				break;
+			if ( score > alpha )
+			{
+				alpha = score;
+				best_index = i;
+			}
+		}
+		if ( best_index < 0 )
+			break;
+		// (result of an interrupted iteration is valid too, because
+		// the best move of the previous iteration is searched first)
+		best_ = moves_[best_index];
+		best_score = alpha;
+		std::rotate( moves_, moves_ + best_index, moves_ + best_index + 1 );
+		_depth = depth; // (of the score)
+		double elapsed = now() - start;
+		DBG( "depth " << depth << ( _stop ? " (incomplete)" : "" ) <<
+		     " best " << Move( best_.x, best_.y, best_.value ) << " score " << best_score <<
+		     " nodes " << _nodes << " nps " << (long)( _nodes / ( elapsed > 0 ? elapsed : 1e-6 ) ) );
+		if ( best_score >= WIN - MAX_PLY || best_score <= -( WIN - MAX_PLY ) )
+			break; // result is certain
+	}
+	return best_score;
+} // iterate
+
+void Engine::symmetry( int sym_, int& x_, int& y_ ) const
+//-------------------------------------------------------------------------------
+{
+	if ( sym_ & 1 )
+		x_ = _BS + 1 - x_;
+	if ( sym_ & 2 )
+		y_ = _BS + 1 - y_;
+	if ( sym_ & 4 )
+		std::swap( x_, y_ );
+}
+
+void Engine::inverseSymmetry( int sym_, int& x_, int& y_ ) const
+//-------------------------------------------------------------------------------
+{
+	if ( sym_ & 4 )
+		std::swap( x_, y_ );
+	if ( sym_ & 1 )
+		x_ = _BS + 1 - x_;
+	if ( sym_ & 2 )
+		y_ = _BS + 1 - y_;
+}
+
+uint64_t Engine::canonicalKey( int who_, int& sym_ ) const
+//-------------------------------------------------------------------------------
+{
+	const uint64_t *keys = _symKey[who_ == 2];
+	sym_ = 0;
+	for ( int sym = 1; sym < 8; sym++ )
+		if ( keys[sym] < keys[sym_] )
+			sym_ = sym;
+	return keys[sym_];
+}
+
+bool Engine::hashMove( Move& move_, int who_ ) const
+//-------------------------------------------------------------------------------
+{
+	TransTable::Entry entry;
+	int sym;
+	if ( !_tt->probe( canonicalKey( who_, sym ), entry ) )
+		return false;
+	inverseSymmetry( sym, entry.x, entry.y );
+	if ( _board[entry.x][entry.y] != 0 )
+		return false;
+	move_.init( entry.x, entry.y );
+	return true;
+}
+
+void Engine::principalVariation( const Move& move_, int who_, vector<Move>& pv_ )
+//-------------------------------------------------------------------------------
+{
+	pv_.clear();
+	Move move( move_ );
+	int who = who_;
+	while ( pv_.size() < MAX_PLY && _board[move.x][move.y] == 0 )
+	{
+		setPiece( move.x, move.y, who );
+		pv_.push_back( move );
+		if ( checkWin( move.x, move.y ) || full() )
+			break;
+		who = 3 - who;
+		if ( !hashMove( move, who ) )
+			break;
+	}
+	for ( size_t i = pv_.size(); i-- > 0; )
+		removePiece( pv_[i].x, pv_[i].y );
+}
+
+bool Engine::findWin( int who_, int& x_, int& y_ ) const
+//-------------------------------------------------------------------------------
+{
+	// find a cell where who_ would make five
+	for ( int i = 0; i < _candCount; i++ )
+	{
+		int x = _cand[i] >> 5;
+		int y = _cand[i] & 31;
+		if ( _eval[who_][x][y].wins() )
+		{
+			x_ = x;
+			y_ = y;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool makesFour( const Eval& e_ )
+//-------------------------------------------------------------------------------
+{
+	return e_.info[1].n == 4 || e_.info[2].n == 4 || e_.info[3].n == 4 || e_.info[4].n == 4;
+}
+
+bool Engine::threat( int who_, int depth_, bool vct_, int ply_ )
+//-------------------------------------------------------------------------------
+{
+	// Threat space search for the attacker who_ (to move):
+	// try only moves making a four (VCF) or also an open three (VCT).
+	// Returns true if this forces a win.
+	_threatNodes++;
+	int opp = 3 - who_;
+	if ( _wins[who_] )
+	{
+		if ( ply_ == 0 )
+		{
+			findWin( who_, _threatMove.x, _threatMove.y );
+			_threatMove.value = moveValue( _threatMove.x, _threatMove.y, who_ );
+		}
+		return true;
+	}
+	if ( depth_ <= 0 || _wins[opp] >= 2 || _threatNodes > _threatLimit ||
+	     ( _abort && _abort->load( std::memory_order_relaxed ) ) ||
+	     ( _deadline > 0 && now() > _deadline ) )
+		return false;
+	if ( _wins[opp] )
+	{
+		// must block the four of the defender (a threat itself only
+		// if it makes a four, or an open three in VCT)
+		int x, y;
+		findWin( opp, x, y );
+		bool three = vct_ && _eval[who_][x][y].has3();
+		setPiece( x, y, who_ );
+		bool result = ( _wins[who_] || ( three && _fours[who_] ) ) &&
+		              defend( who_, x, y, depth_ - 1, vct_, ply_ + 1 );
+		removePiece( x, y );
+		if ( result && ply_ == 0 )
+			_threatMove.x = x, _threatMove.y = y, _threatMove.value = moveValue( x, y, who_ );
+		return result;
+	}
+	// fours first, then threes
+	short cells[MAX_MOVES];
+	int n = candidates( cells );
+	for ( int pass = 0; pass < ( vct_ ? 2 : 1 ); pass++ )
+	{
+		for ( int i = 0; i < n; i++ )
+		{
+			int x = cells[i] >> 5;
+			int y = cells[i] & 31;
+			const Eval& e = _eval[who_][x][y];
+			bool four = makesFour( e );
+			if ( pass == 0 ? !four : ( four || !e.has3() ) )
+				continue;
+			setPiece( x, y, who_ );
+			bool result = ( _wins[who_] || ( pass && _fours[who_] ) ) &&
+			              defend( who_, x, y, depth_ - 1, vct_, ply_ + 1 );
+			removePiece( x, y );
+			if ( result )
+			{
+				if ( ply_ == 0 )
+					_threatMove.x = x, _threatMove.y = y, _threatMove.value = moveValue( x, y, who_ );
+				return true;
+			}
+		}
+	}
+	return false;
+} // threat
+
+bool Engine::defend( int who_, int x_, int y_, int depth_, bool vct_, int ply_ )
+//-------------------------------------------------------------------------------
+{
+	// Defender (opponent of who_) to move after the threat move x_/y_.
+	// Returns true if the attacker still wins after every sensible defence.
+	_threatNodes++;
+	int opp = 3 - who_;
+	if ( _wins[opp] )
+		return false; // defender wins first
+	if ( _wins[who_] >= 2 )
+		return true; // can't block both
+	if ( _wins[who_] )
+	{
+		// only the block helps
+		int x, y;
+		findWin( who_, x, y );
+		setPiece( x, y, opp );
+		bool result = threat( who_, depth_, vct_, ply_ + 1 );
+		removePiece( x, y );
+		return result;
+	}
+	// a three: try all empty cells near the three on its line(s)
+	// and the fours of the defender.
+	Eval e;
+	countPos( x_, y_, e );
+	bool tried[24][24] = {};
+	for ( int dir = 1; dir <= 4; dir++ )
+	{
+		if ( !e.info[dir].has3() )
+			continue;
+		for ( int d = -5; d <= 5; d++ )
+		{
+			int x = x_ + d * DIR[dir][0];
+			int y = y_ + d * DIR[dir][1];
+			if ( x < 1 || x > _BS || y < 1 || y > _BS || _board[x][y] != 0 )
+				continue;
+			tried[x][y] = true;
+			setPiece( x, y, opp );
+			bool result = threat( who_, depth_, vct_, ply_ + 1 );
+			removePiece( x, y );
+			if ( !result )
+				return false;
+		}
+	}
+	short cells[MAX_MOVES];
+	int n = candidates( cells );
+	for ( int i = 0; i < n; i++ )
+	{
+		int x = cells[i] >> 5;
+		int y = cells[i] & 31;
+		if ( tried[x][y] || !makesFour( _eval[opp][x][y] ) )
+			continue;
+		setPiece( x, y, opp );
+		bool result = threat( who_, depth_, vct_, ply_ + 1 );
+		removePiece( x, y );
+		if ( !result )
+			return false;
+	}
+	return true;
+} // defend
+
+bool Engine::solve( Move& move_, int who_, bool vct_/* = true*/ )
+//-------------------------------------------------------------------------------
+{
+	// look for a forced win by continuous fours (VCF) or threes and fours (VCT)
+	double start = now();
+	bool vct = false;
+	_threatNodes = 0;
+	bool found = _vcfDepth && threat( who_, _vcfDepth, false, 0 );
+	long nodes = _threatNodes;
+	if ( !found && vct_ && _vctDepth )
+	{
+		vct = true;
+		_threatNodes = 0;
+		found = threat( who_, _vctDepth, true, 0 );
+		nodes += _threatNodes;
+	}
+	_nodes += nodes;
+	double elapsed = now() - start;
+	if ( found )
+	{
+		_score = WIN - MAX_PLY;
+		move_.init( _threatMove.x, _threatMove.y, _threatMove.value );
+		DBG( ( vct ? "VCT" : "VCF" ) << " win at " << move_ << " (" << nodes << " nodes, "
+		     << (long)( elapsed * 1e6 ) << " us)" );
+	}
+	else
+		DBG( "no VCF/VCT (" << nodes << " nodes, " << (long)( elapsed * 1e6 ) << " us)" );
+	return found;
+} // solve
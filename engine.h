@@ -0,0 +1,455 @@
+/*
+
+ FLTK Gomoku - move engine
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#ifndef ENGINE_H
+#define ENGINE_H
+
+// The engine has no dependencies on FLTK, so it can be used by the
+// GUI as well as by headless tools (see Makefile target 'libengine.a').
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include "bitboard.h"
+
+class Book;
+class EndgameDB;
+
+//-------------------------------------------------------------------------------
+struct PosInfo
+//-------------------------------------------------------------------------------
+{
+	int n;
+	int f1;
+	int f2;
+	int gap;
+	PosInfo() :
+		n( 0 ),
+		f1( 0 ),
+		f2( 0 ),
+		gap( 0 )
+	{}
+	void init() { n = 0; f1 = 0; f2 = 0; gap = 0; }
+	bool has5() const { return n == 5; }
+	bool wins() const { return has5(); }
+	bool canWin() const { return n + f1 + f2 + gap >= 5 && ( f1 && f2 ); }
+	bool has4() const { return n == 4 && !gap && canWin(); }
+	bool has3() const
+	{
+		return ( n == 3 && canWin() ) || ( n == 4 && !gap && single_freedom() );
+	}
+	bool has2() const
+	{
+		return ( n == 2 && !gap && canWin() );
+	}
+	bool has3nogap() const
+	{
+		return ( n == 3 && !gap && canWin() ) || ( n == 4 && !gap && single_freedom() );
+	}
+	bool single_freedom() const
+	{
+		return ( !f1 && f2 ) || ( f1 && !f2 );
+	}
+};
+
+// Board with a border of -1 around the playing area (max. 20x20)
+typedef char Board[24][24];
+
+//-------------------------------------------------------------------------------
+struct Eval
+//-------------------------------------------------------------------------------
+{
+	PosInfo info[4 + 1];
+	void init()
+	{
+		for ( int i = 1; i <= 4; i++ )
+			info[i].init();
+	}
+	bool wins() const
+	{
+		return info[1].wins() || info[2].wins() || info[3].wins() || info[4].wins();
+	}
+	int has4() const
+	{
+		return info[1].has4() + info[2].has4() + info[3].has4() + info[4].has4();
+	}
+	int has3() const
+	{
+		return info[1].has3() + info[2].has3() + info[3].has3() + info[4].has3();
+	}
+	int has3nogap() const
+	{
+		return info[1].has3nogap() + info[2].has3nogap() + info[3].has3nogap() + info[4].has3nogap();
+	}
+	bool has3Fork() const
+	{
+		return ( info[1].has3() || info[1].has4() ) +
+		       ( info[2].has3() || info[2].has4() ) +
+		       ( info[3].has3() || info[3].has4() ) +
+		       ( info[4].has3() || info[4].has4() ) >= 2;
+	}
+	int has2() const
+	{
+		return info[1].has2() + info[2].has2() + info[3].has2() + info[4].has2();
+	}
+};
+
+//-------------------------------------------------------------------------------
+struct Move
+//-------------------------------------------------------------------------------
+{
+	int x;
+	int y;
+	int value;
+	Eval eval;
+	Move( int x_ = 0, int y_ = 0, int value_ = 0 ) :
+		x( x_ ),
+		y( y_ ),
+		value( value_ )
+	{}
+	Move( const std::string& s_ );
+	void init( int x_ = 0, int y_ = 0, int value_ = 0 )
+	{
+		x = x_;
+		y = y_;
+		value = value_;
+		eval.init();
+	}
+	std::string asString() const;
+	virtual std::ostream& printOn( std::ostream& os_ ) const;
+	bool valid() const
+	{
+		return x > 0 && y > 0;
+	}
+};
+
+std::ostream& operator<<( std::ostream &os_, const Move &m_ );
+
+int count( int x_, int y_, int dx_, int dy_, PosInfo &info_, const Board &board_ );
+
+//-------------------------------------------------------------------------------
+class Random
+//-------------------------------------------------------------------------------
+{
+	// xoshiro256** pseudo random numbers (seeded with splitmix64), so that
+	// games and benchmarks can be reproduced with the same seed.
+public:
+	Random( uint64_t seed_ = 0 ) { seed( seed_ ); }
+	void seed( uint64_t seed_ );
+	uint64_t next();
+	// uniform number in [0, n_)
+	uint32_t operator()( uint32_t n_ ) { return (uint32_t)( ( ( next() >> 32 ) * n_ ) >> 32 ); }
+	// advance by 2^128 numbers: an independent stream (e.g. for a thread)
+	void jump();
+private:
+	uint64_t _s[4];
+};
+
+//-------------------------------------------------------------------------------
+class TimeControl
+//-------------------------------------------------------------------------------
+{
+	// Clock of one side and the search time for its next move:
+	// TC_Move: fixed time per move (no clock)
+	// TC_SuddenDeath: time for all moves of the game
+	// TC_Increment: as sudden death, plus an increment after each move
+public:
+	enum Mode { TC_Move, TC_SuddenDeath, TC_Increment };
+	TimeControl( Mode mode_ = TC_Move, double time_ = 1, double increment_ = 0 );
+	// "300" (sudden death) or "300+2" (increment) in seconds
+	bool parse( const std::string& s_ );
+	Mode mode() const { return _mode; }
+	double time() const { return _time; }
+	double increment() const { return _increment; }
+	// new game: the clock starts with the full time
+	void reset() { _remaining = _time; }
+	double remaining() const { return _remaining; }
+	bool expired() const { return _mode != TC_Move && _remaining <= 0; }
+	// search time for the next move with pieces_ pieces on the board
+	double budget( int pieces_, int size_ ) const;
+	// the move took seconds_
+	void used( double seconds_ );
+	// remaining time as m:ss (or s.s below 10 seconds)
+	static std::string format( double seconds_ );
+private:
+	Mode _mode;
+	double _time;
+	double _increment;
+	double _remaining;
+};
+
+//-------------------------------------------------------------------------------
+struct Weights
+//-------------------------------------------------------------------------------
+{
+	// Weights of the evaluation: the value of an empty cell for a colour
+	// (Engine::value(), the leaf evaluation sums them over the empty cells)
+	// and the bias of a move for the side to move (Engine::eval()).
+	// Loaded from / saved to a text file with one "name value" per line.
+	enum { W_Win, W_Four, W_Fork, W_ThreeOpen, W_Three, W_Two, W_WinFactor, W_OwnBonus, W_Count };
+	int win = 100000;    // cell makes five
+	int four = 10000;    // per four
+	int fork = 1000;     // lines with three or four in two directions
+	int threeOpen = 200; // per three, if one of them has no gap
+	int three = 50;      // per three
+	int two = 10;        // per two
+	int winFactor = 10;  // own five: value times this
+	int ownBonus = 1;    // own move above an equal one of the opponent
+	int& operator[]( int i_ );
+	int operator[]( int i_ ) const { return const_cast<Weights&>( *this )[i_]; }
+	static const char *name( int i_ );
+	bool load( const std::string& file_ );
+	bool save( const std::string& file_ ) const;
+};
+
+//-------------------------------------------------------------------------------
+class TransTable
+//-------------------------------------------------------------------------------
+{
+	// Lock-free transposition table: each entry stores the key xor'ed
+	// with the data, so a torn write by another thread is detected as a miss.
+public:
+	enum Bound { TT_None, TT_Exact, TT_Lower, TT_Upper };
+	struct Entry
+	{
+		int score;
+		int depth;
+		Bound bound;
+		int x;
+		int y;
+	};
+	TransTable( size_t mb_ = 16 );
+	void resize( size_t mb_ );
+	void clear();
+	size_t size() const { return _size; }
+	bool probe( uint64_t key_, Entry& entry_ ) const;
+	void store( uint64_t key_, const Entry& entry_ );
+	// statistics
+	uint64_t probes() const { return _probes; }
+	uint64_t hits() const { return _hits; }
+	void resetStats() { _probes = 0; _hits = 0; }
+private:
+	struct Slot
+	{
+		std::atomic<uint64_t> key;
+		std::atomic<uint64_t> data;
+	};
+	std::unique_ptr<Slot[]> _slots;
+	size_t _size; // number of slots (power of two)
+	mutable std::atomic<uint64_t> _probes;
+	mutable std::atomic<uint64_t> _hits;
+};
+
+//-------------------------------------------------------------------------------
+class Engine
+//-------------------------------------------------------------------------------
+{
+public:
+	// (BS_Max is the largest board, 20x20 as used by Gomocup freestyle)
+	enum BoardSize { BS_Small = 11, BS_Medium = 15, BS_Standard = 19, BS_Max = 20 };
+	// implementation used for the line counting of the evaluation cache
+	// (CT_Table limits the freedoms to BitBoard::WINDOW cells, so only cells
+	// within this distance of a move need an update)
+	enum Counter { CT_Scalar, CT_BitBoard, CT_Table };
+	// score of a win (less the plies to it), scores of at least
+	// WIN_SCORE - 64 are forced wins (at most -(WIN_SCORE - 64) losses)
+	enum { WIN_SCORE = 1000000000 };
+	Engine( int size_ = BS_Standard );
+	// position
+	int size() const { return _BS; }
+	void size( int size_ );
+	void clearBoard();
+	int at( int x_, int y_ ) const { return _board[x_][y_]; }
+	int pieces() const { return _pieces; }
+	bool full() const { return _pieces >= _BS * _BS; }
+	const Board& board() const { return _board; }
+	void setPiece( int x_, int y_, int who_ );
+	void removePiece( int x_, int y_ );
+	void makeMove( const Move& move_, int who_ ) { setPiece( move_.x, move_.y, who_ ); }
+	void unmakeMove( const Move& move_ ) { removePiece( move_.x, move_.y ); }
+	bool loadBoard( std::istream& is_, int player_, int& lastMoved_, Move& lastMove_ );
+	std::ostream& dumpBoard( std::ostream& os_, const Move& lastMove_, int player_ ) const;
+	// game record: one line per move pair (player_ tab other), '-' if
+	// the other colour began (moves_ must be on the board)
+	std::ostream& dumpGame( std::ostream& os_, const std::vector<Move>& moves_, int player_ ) const;
+	// search
+	void countPos( int x_, int y_, Eval &pos_, const Board &board_ ) const;
+	void countPos( int x_, int y_, Eval &pos_ ) const;
+	void countPos( Move &move, const Board &board_ ) const;
+	bool checkWin( int x_, int y_ ) const;
+	bool findMove( Move& move_, int who_ );
+	bool greedyMove( Move& move_, int who_ ) const;
+	bool randomMove( Move& move_ ) const;
+	// score of move_ for who_ searched to depth_ as a root move (the full
+	// window, no time limit), e.g. to compare a move with the one found by
+	// findMove() at its depth()
+	int scoreMove( const Move& move_, int who_, int depth_ );
+	// random numbers for randomMove() and choosing between moves of same value
+	// (a copy of the engine continues the same sequence unless jump()'ed)
+	void seed( uint64_t seed_ ) { _rng.seed( seed_ ); }
+	void jump() { _rng.jump(); }
+	int evaluate( Move& m_, int who_ ) const;
+	int eval( Move& move_, int who_ ) const;
+	// search parameters (a search time of 0 selects the greedy one ply search)
+	double searchTime() const { return _searchTime; }
+	void searchTime( double searchTime_ ) { _searchTime = searchTime_; }
+	int searchDepth() const { return _searchDepth; }
+	void searchDepth( int searchDepth_ ) { _searchDepth = searchDepth_; }
+	int searchWidth() const { return _searchWidth; }
+	void searchWidth( int searchWidth_ ) { _searchWidth = searchWidth_; }
+	// number of search threads (main thread plus Lazy SMP helpers)
+	int threads() const { return _threads; }
+	void threads( int threads_ ) { _threads = threads_ < 1 ? 1 : threads_; }
+	// threat space search (max. number of own threat moves, 0 disables)
+	int vcfDepth() const { return _vcfDepth; }
+	void vcfDepth( int vcfDepth_ ) { _vcfDepth = vcfDepth_; }
+	int vctDepth() const { return _vctDepth; }
+	void vctDepth( int vctDepth_ ) { _vctDepth = vctDepth_; }
+	long threatLimit() const { return _threatLimit; }
+	void threatLimit( long threatLimit_ ) { _threatLimit = threatLimit_; }
+	// forced win by VCF, then by VCT (unless vct_ is false)
+	bool solve( Move& move_, int who_, bool vct_ = true );
+	// stop a running findMove() from another thread when *abort_ is set
+	void abort( std::atomic<bool> *abort_ ) { _abort = abort_; }
+	// best move for who_ from the transposition table (e.g. to predict
+	// the opponent's reply for pondering)
+	bool hashMove( Move& move_, int who_ ) const;
+	// move_ of who_ followed by the best replies from the transposition
+	// table (up to a five or a position not in the table)
+	void principalVariation( const Move& move_, int who_, std::vector<Move>& pv_ );
+	// transposition table size in MB (shared by copies of the engine)
+	void hashSize( size_t mb_ ) { _tt = std::make_shared<TransTable>( mb_ ); }
+	uint64_t hash() const { return _symKey[0][0]; }
+	// Zobrist key of the position with who_'s pieces as colour 1, the
+	// smallest of the 8 symmetric positions (sym_ is the symmetry giving it).
+	// Used by the transposition table and the book, so symmetric positions
+	// (and those with the colours swapped) share their entries.
+	uint64_t canonicalKey( int who_, int& sym_ ) const;
+	// cell x_/y_ under symmetry sym_ (bit 0: mirror x, 1: mirror y,
+	// 2: swap x and y) and back
+	void symmetry( int sym_, int& x_, int& y_ ) const;
+	void inverseSymmetry( int sym_, int& x_, int& y_ ) const;
+	// opening book used by findMove() (shared by copies of the engine)
+	void book( std::shared_ptr<const Book> book_ ) { _book = book_; }
+	// proven results used by findMove() after the book (shared as well)
+	void endgame( std::shared_ptr<const EndgameDB> egdb_ ) { _egdb = egdb_; }
+	// search statistics of last findMove() (nodes include the threat search,
+	// the score is for the side to move, WIN_SCORE - 64 for a forced win
+	// without its distance, 0 if not searched; the depth is that of the
+	// move and its score, its iteration may be unfinished)
+	long nodes() const { return _nodes; }
+	int depth() const { return _depth; }
+	int score() const { return _score; }
+	Counter counter() const { return _counter; }
+	void counter( Counter counter_ );
+	// evaluation weights (the evaluation of the position is recounted)
+	const Weights& weights() const { return _weights; }
+	void weights( const Weights& weights_ );
+	// terms of the leaf evaluation from the view of who_: per weight the
+	// number of times value() adds it over the empty cells, who_'s less the
+	// opponent's (cells making five excluded), so the leaf evaluation is the
+	// sum of weights times terms. Returns false if a side can make five or
+	// who_ can make an open four (not a quiet position).
+	bool evalTerms( int who_, int terms_[Weights::W_Count] ) const;
+	// diagnostics
+	int debug() const { return _debug; }
+	void debug( int debug_ ) { _debug = debug_; }
+	void logStream( std::ostream *logStream_ ) { _logStream = logStream_; }
+private:
+	struct SearchMove
+	{
+		int x;
+		int y;
+		int value;
+		bool operator<( const SearchMove& m_ ) const { return value > m_.value; }
+	};
+	enum { MAX_MOVES = BS_Max * BS_Max, MAX_PLY = 64 };
+	void initEval();
+	void recountEval();
+	void updateKeys( int x_, int y_, int who_ );
+	void updateEval( int x_, int y_ );
+	void updateEval( int x_, int y_, int dir_ );
+	void countEval( int x_, int y_, int dir_ );
+	void account( int x_, int y_, int sign_ );
+	void updateCandidates( int x_, int y_, int delta_ );
+	void addCandidate( int x_, int y_ );
+	void removeCandidate( int x_, int y_ );
+	int candidates( short *cells_ ) const;
+	int value( const Eval& e_ ) const;
+	int moveValue( int x_, int y_, int who_ ) const;
+	int staticValue( int who_ ) const;
+	int generateMoves( int who_, SearchMove *moves_, bool& win_ ) const;
+	int negamax( int who_, int depth_, int alpha_, int beta_, int ply_ );
+	bool search( Move& move_, int who_ );
+	int iterate( int who_, SearchMove *moves_, int n_, int depth_, SearchMove& best_ );
+	bool timeUp();
+	bool threat( int who_, int depth_, bool vct_, int ply_ );
+	bool defend( int who_, int x_, int y_, int depth_, bool vct_, int ply_ );
+	bool findWin( int who_, int& x_, int& y_ ) const;
+private:
+	int _BS;
+	Board _board;
+	Weights _weights;
+	// cached evaluation of every empty cell for both colours ([who][x][y]),
+	// as if a piece of that colour was set there.
+	Eval _eval[2 + 1][24][24];
+	int _value[2 + 1][24][24]; // value() of _eval
+	// sum of cached cell values and number of winning cells per colour
+	int _total[2 + 1];
+	int _wins[2 + 1];
+	int _fours[2 + 1]; // number of cells that make an open four
+	// Zobrist keys of the position in the 8 symmetric orientations,
+	// [0] with the colours as they are, [1] with the colours swapped
+	uint64_t _symKey[2][8];
+	// candidate cells for moves: empty cells at most 2 cells away from a piece
+	// (packed as x << 5 | y, _candIndex is the position in _cand or -1)
+	short _cand[MAX_MOVES];
+	int _candCount;
+	short _candIndex[24][24];
+	int _near[24][24]; // number of pieces at most 2 cells away
+	int _pieces;
+	BitBoard _bits;
+	Counter _counter;
+	std::shared_ptr<TransTable> _tt;
+	std::shared_ptr<const Book> _book;
+	std::shared_ptr<const EndgameDB> _egdb;
+	double _searchTime;
+	int _searchDepth;
+	int _searchWidth;
+	int _vcfDepth;
+	int _vctDepth;
+	long _threatNodes;
+	long _threatLimit; // max. nodes of one threat search
+	SearchMove _threatMove;
+	int _threads;
+	int _helper; // number of helper thread (0 = main)
+	mutable Random _rng;
+	std::atomic<bool> *_abort; // set when helpers should stop
+	long _nodes;
+	int _depth;
+	int _score;
+	bool _stop;
+	double _deadline;
+	int _debug;
+	std::ostream *_logStream;
+};
+
+#endif // ENGINE_H
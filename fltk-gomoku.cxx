@@ -43,7 +43,14 @@
 #include <ctime>
 #include <filesystem>
 #include <exception>
+#include <thread>
+#include <memory>
+#include <atomic>
+#include <chrono>
 #include "welcome.h"
+#include "engine.h"
+#include "book.h"
+#include "egdb.h"
 
 #ifdef USE_MINIAUDIO
 #define MA_IMPLEMENTATION
@@ -92,226 +99,6 @@ static int COMPUTER = 2;
 
 
 
-//-------------------------------------------------------------------------------
-struct PosInfo
-//-------------------------------------------------------------------------------
-{
-	int n;
-	int f1;
-	int f2;
-	int gap;
-	PosInfo() :
-		n( 0 ),
-		f1( 0 ),
-		f2( 0 ),
-		gap( 0 )
-	{}
-	void init() { n = 0; f1 = 0; f2 = 0; gap = 0; }
-	bool has5() const { return n == 5; }
-	bool wins() const { return has5(); }
-	bool canWin() const { return n + f1 + f2 + gap >= 5 && ( f1 && f2 ); }
-	bool has4() const { return n == 4 && !gap && canWin(); }
-	bool has3() const
-	{
-		return ( n == 3 && canWin() ) || ( n == 4 && !gap && single_freedom() );
-	}
-	bool has2() const
-	{
-		return ( n == 2 && !gap && canWin() );
-	}
-	bool has3nogap() const
-	{
-		return ( n == 3 && !gap && canWin() ) || ( n == 4 && !gap && single_freedom() );
-	}
-	bool single_freedom() const
-	{
-		return ( !f1 && f2 ) || ( f1 && !f2 );
-	}
-};
-
-typedef char Board[24][24];
-
-//-------------------------------------------------------------------------------
-struct Eval
-//-------------------------------------------------------------------------------
-{
-	PosInfo info[4 + 1];
-	void init()
-	{
-		for ( int i = 1; i <= 4; i++ )
-			info[i].init();
-	}
-	bool wins() const
-	{
-		return info[1].wins() || info[2].wins() || info[3].wins() || info[4].wins();
-	}
-	int has4() const
-	{
-		return info[1].has4() + info[2].has4() + info[3].has4() + info[4].has4();
-	}
-	int has3() const
-	{
-		return info[1].has3() + info[2].has3() + info[3].has3() + info[4].has3();
-	}
-	int has3nogap() const
-	{
-		return info[1].has3nogap() + info[2].has3nogap() + info[3].has3nogap() + info[4].has3nogap();
-	}
-	bool has3Fork() const
-	{
-		return ( info[1].has3() || info[1].has4() ) +
-		       ( info[2].has3() || info[2].has4() ) +
-		       ( info[3].has3() || info[3].has4() ) +
-		       ( info[4].has3() || info[4].has4() ) >= 2;
-	}
-	int has2() const
-	{
-		return info[1].has2() + info[2].has2() + info[3].has2() + info[4].has2();
-	}
-};
-
-//-------------------------------------------------------------------------------
-struct Move
-//-------------------------------------------------------------------------------
-{
-	int x;
-	int y;
-	int value;
-	Eval eval;
-	Move( int x_ = 0, int y_ = 0, int value_ = 0 ) :
-		x( x_ ),
-		y( y_ ),
-		value( value_ )
-	{}
-	Move( const string& s_ )
-	{
-		init();
-		if ( ( s_.size() == 2 && s_[0] != '#' ) || ( s_.size() == 3 && s_[0] == '#' ) )
-		{
-			char X = s_[0] == '#' ? s_[2] : s_[1];
-			char Y = s_[0] == '#' ? s_[1] : s_[0];
-			x = X - 'a' + 1;
-			y = Y - 'A' + 1;
-		}
-	}
-	void init( int x_ = 0, int y_ = 0, int value_ = 0 )
-	{
-		x = x_;
-		y = y_;
-		value = value_;
-		eval.init();
-	}
-	string asString() const
-	{
-		ostringstream os;
-		os << "#" << (char)( y + 'A' - 1 ) << (char)( x + 'a' - 1 );
-		return os.str();
-	}
-	virtual std::ostream& printOn( std::ostream& os_ ) const
-	{
-		os_ << asString() << " (" << x << "/" << y << ") value: " << value;
-		return os_;
-	}
-	bool valid() const
-	{
-		return x > 0 && y > 0;
-	}
-};
-
-std::ostream& operator<<( std::ostream &os_, const Move &m_ )
-{
-	return m_.printOn( os_ );
-}
-
-static int count( int x_, int y_, int dx_, int dy_, PosInfo &info_,
-                  const Board &board_ )
-//-------------------------------------------------------------------------------
-{
-	info_.init();
-	int c = board_[x_][y_];
-	if ( c <= 0 )
-		return 0;
-
-	// count total pieces in row
-	info_.n = 1;
-	int x = x_ + dx_;
-	int y = y_ + dy_;
-	while ( board_[x][y] == c )
-	{
-		info_.n++;
-		x += dx_;
-		y += dy_;
-	}
-	// one side end position after row (not c)
-	int e1x = x;
-	int e1y = y;
-
-	x = x_ - dx_;
-	y = y_ - dy_;
-	while ( board_[x][y] == c )
-	{
-		info_.n++;
-		x -= dx_;
-		y -= dy_;
-	}
-	// if five or more everything else is unimportant
-	if ( info_.n >= 5 )
-		return info_.n;
-
-	// count freedoms and same color in each direction
-	while ( board_[x][y] == 0 )
-	{
-		info_.f2++;
-		x -= dx_;
-		y -= dy_;
-	}
-	int n2 = 0;
-	while ( board_[x][y] == c )
-	{
-		n2++;
-		x -= dx_;
-		y -= dy_;
-	}
-
-	x = e1x;
-	y = e1y;
-
-	while ( board_[x][y] == 0 )
-	{
-		info_.f1++;
-		x += dx_;
-		y += dy_;
-	}
-	int n1 = 0;
-	while ( board_[x][y] == c )
-	{
-		n1++;
-		x += dx_;
-		y += dy_;
-	}
-
-	//  n1  f1   n    f2   n2
-	//  o o . . o o o . . o o
-	int n = info_.n;
-	if ( info_.f1 == 1 ) // gap of 1
-	{
-		int t = info_.n + 1 + n1;
-		if ( t <= 5 )
-			n = info_.n + n1;
-	}
-	if ( info_.f2 == 1 ) // gap of 1
-	{
-		int t = info_.n + 1 + n2;
-		if ( t <= 5 && t > n )
-			n = info_.n + n2;
-	}
-
-	info_.gap = n != info_.n ? 1 : 0;
-	info_.n = n;
-
-	return info_.n;
-} // count
-
 //-------------------------------------------------------------------------------
 struct Args
 //-------------------------------------------------------------------------------
@@ -320,6 +107,11 @@ struct Args
 	string boardFile;
 	string logFile;
 	string boardSize;
+	uint64_t seed = 0;
+	string timeControl;
+	string bookFile;
+	string egdbFile;
+	string weightsFile;
 };
 
 //-------------------------------------------------------------------------------
@@ -327,7 +119,7 @@ class Gomoku : public Fl_Double_Window
 //-------------------------------------------------------------------------------
 {
 #define DBG(a) { if ( _debug ) *_logStream << a << endl; }
-	enum BoardSize { BS_Small = 11, BS_Medium = 15, BS_Standard = 19 };
+	typedef Engine::BoardSize BoardSize;
 	typedef Fl_Double_Window Inherited;
 public:
 	Gomoku( int argc_ = 0, char *argv_[] = 0 );
@@ -347,7 +139,6 @@ public:
 	std::ostream& dumpGame( std::ostream& os_ = std::cout ) const;
 	void makeMove();
 	void setPiece( const Move& move_, int who_ );
-	void wait( double delay_ );
 	virtual int handle( int e_ );
 	virtual void draw();
 	bool clearBgImage();
@@ -362,30 +153,37 @@ protected:
 	void selectBoardColor();
 	void selectGridColor();
 	void setBgImage( Fl_Image *bgTile_ );
-	bool waitKey();
+	void waitKey( void (Gomoku::*then_)() );
 	std::string yourMovePrompt() const;
 private:
 	int xp( int x_ ) const;
 	int yp( int y_ ) const;
 	void onMove();
-	int count( int x_, int y_, int dx_, int dy_, PosInfo& info_ ) const;
-	void countPos( int x_, int y_, Eval &pos_, const Board &board_ ) const;
-	void countPos( int x_, int y_, Eval &pos_ ) const;
-	void countPos( Move &move, const Board &board_ ) const;
-	bool checkWin( int x_, int y_ ) const;
-	bool findMove( Move& move_ ) const;
 	void finishedMessage( int winner_ );
 	void gameFinished( int winner_ );
-	bool randomMove( Move& move_ ) const;
-	int evaluate( Move& m_, int who_ ) const;
-	int eval( Move& move_ ) const;
+	void onGameFinished();
+	void onGameFinishedKey();
+	void onReplayKey();
+	void onKey();
+	void keyPressed();
 	Move getMoveFromMousePosition() const;
 	int handleGameEvent( int e_ );
 	int handleWaitClickEvent( int e_ );
 	void initPlay();
 	bool loadBoard( istream& is_ );
-	void onDelay();
 	void onNextMove();
+	void onSearchDone( int id_, const Move& move_, bool random_ );
+	void onStopSearch();
+	void startSearch( std::shared_ptr<Engine> engine_, int who_, int id_ );
+	void startPonder();
+	void stopPonder();
+	void finishMove();
+	void cancelSearch();
+	void startClock( int who_ );
+	void stopClock();
+	void onClock();
+	double clockTime( int who_ ) const;
+	double moveTime() const;
 	bool popupMenu();
 	void selectAndLoadBgImage();
 	void selectAndSaveBoard();
@@ -397,7 +195,6 @@ private:
 	bool takeBackMoves();
 	void dmsg( const string& m_ ) { _dmsg = m_; redraw(); }
 	void message( const string& m_ ) { _message = m_; redraw(); }
-	void pondering( bool pondering_ ) { _pondering = pondering_; }
 	void onMenu( void *d_ );
 	void replayInfoMessage();
 	void updateGameStats( int winner_ );
@@ -410,13 +207,34 @@ private:
 	{
 		static_cast<Gomoku *>( d_ )->onNextMove();
 	}
-	static void cb_ponder( void *d_ )
+	static void cb_stop_search( void *d_ )
+	{
+		static_cast<Gomoku *>( d_ )->onStopSearch();
+	}
+	// result of the search thread (passed by Fl::awake())
+	struct SearchResult
+	{
+		Gomoku *gomoku;
+		int id;
+		Move move;
+		bool random; // (no move found, logged by the GUI thread)
+	};
+	static void cb_search_done( void *d_ )
+	{
+		std::unique_ptr<SearchResult> r( static_cast<SearchResult *>( d_ ) );
+		r->gomoku->onSearchDone( r->id, r->move, r->random );
+	}
+	static void cb_clock( void *d_ )
 	{
-		(static_cast<Gomoku *>(d_))->pondering( false );
+		static_cast<Gomoku *>( d_ )->onClock();
 	}
-	static void cb_delay( void *d_ )
+	static void cb_game_finished( void *d_ )
 	{
-		static_cast<Gomoku *>( d_ )->onDelay();
+		static_cast<Gomoku *>( d_ )->onGameFinished();
+	}
+	static void cb_key( void *d_ )
+	{
+		static_cast<Gomoku *>( d_ )->onKey();
 	}
 	static void cb_menu( Fl_Widget *w_, void *d_ )
 	{
@@ -424,13 +242,35 @@ private:
 	}
 private:
 	BoardSize _BS;
-	Board _board;
-	Eval _eval[24][24];
+	Engine _engine;
 	bool _player;
-	bool _pondering;
+	bool _searching; // search for the computer move running
+	bool _pondering; // search for the answer to _ponderMove running
+	bool _ponderDone; // result of pondering is in _searchMove
+	int _ponderWho; // colour searched by pondering
+	Move _ponderMove; // predicted move of the player
+	uint64_t _ponderKey; // hash of the position pondered on (with _ponderMove)
+	std::chrono::steady_clock::time_point _ponderStart;
+	int _ponder; // pondering enabled
+	int _ponderHits;
+	int _ponderCount;
+	// searches are numbered, results of discarded ones are ignored
+	int _nextId;
+	int _searchId; // id of the search for the computer move
+	int _ponderId; // id of the ponder search
+	int _threadId; // id of search run by _searchThread
+	std::thread _searchThread;
+	std::atomic<bool> _searchAbort; // stops search of _searchThread
+	Move _searchMove;
+	// clock per colour (the one of _clockWho is running since _clockStart)
+	TimeControl _clock[2 + 1];
+	int _clockWho;
+	std::chrono::steady_clock::time_point _clockStart;
+	bool _timeLoss; // game was lost on time
 	Move _move;
 	Move _lastMove;
-	bool _waiting;
+	int _winner; // winner of finished game (shown after a short delay)
+	void (Gomoku::*_onKey)(); // continuation when waiting for a key (click)
 	int _games;
 	int _moves;
 	int _player_wins;
@@ -444,6 +284,7 @@ private:
 	vector<Move> _replayMoves;
 	int _debug; // Note: using int instead of bool for signature of preferences
 	int _alert; // Note: as above
+	int _hashSize;
 	Fl_Preferences *_cfg;
 	string _message;
 	string _dmsg;
@@ -472,10 +313,25 @@ private:
 
 Gomoku::Gomoku( int argc_/* = 0*/, char *argv_[]/* = 0*/ ) :
 	Inherited( 600, 600, "FLTK Gomoku (\"5 in a row\")" ),
-	_BS( BS_Standard ), // board size
+	_BS( Engine::BS_Standard ), // board size
 	_player( true ),
+	_searching( false ),
 	_pondering( false ),
-	_waiting( false ),
+	_ponderDone( false ),
+	_ponderWho( 0 ),
+	_ponderKey( 0 ),
+	_ponder( 1 ),
+	_ponderHits( 0 ),
+	_ponderCount( 0 ),
+	_nextId( 0 ),
+	_searchId( 0 ),
+	_ponderId( 0 ),
+	_threadId( 0 ),
+	_searchAbort( false ),
+	_clockWho( 0 ),
+	_timeLoss( false ),
+	_winner( 0 ),
+	_onKey( 0 ),
 	_games( 0 ),
 	_moves( 0 ),
 	_player_wins( 0 ),
@@ -487,6 +343,7 @@ Gomoku::Gomoku( int argc_/* = 0*/, char *argv_[]/* = 0*/ ) :
 	_playerAsWhite( true ),
 	_debug( 0 ),
 	_alert( false ),
+	_hashSize( 16 ),
 	_logStream( &std::cout )
 //-------------------------------------------------------------------------------
 {
@@ -496,9 +353,13 @@ Gomoku::Gomoku( int argc_/* = 0*/, char *argv_[]/* = 0*/ ) :
 	if ( _args.logFile.size() )
 		_logStream = new ofstream( _args.logFile.c_str() );
 	if ( _args.boardSize == "medium" )
-		_BS = BS_Medium;
+		_BS = Engine::BS_Medium;
 	else if ( _args.boardSize == "small" )
-		_BS = BS_Small;
+		_BS = Engine::BS_Small;
+	_engine.size( _BS );
+	_engine.logStream( _logStream );
+	// (a fixed seed replays the same random moves)
+	_engine.seed( _args.seed ? _args.seed : time( 0 ) );
 
 
 	// Widget for background graphics
@@ -541,6 +402,67 @@ Gomoku::Gomoku( int argc_/* = 0*/, char *argv_[]/* = 0*/ ) :
 
 	_cfg->get( "debug", _debug, _debug );
 	_cfg->get( "alert", _alert, _alert );
+	_engine.debug( _debug );
+	double search_time;
+	_cfg->get( "search_time", search_time, 0.8 );
+	_engine.searchTime( search_time );
+	_cfg->get( "hash_size", _hashSize, 16 ); // transposition table in MB
+	_engine.hashSize( _hashSize );
+	int threads;
+	_cfg->get( "threads", threads, (int)std::thread::hardware_concurrency() );
+	_engine.threads( threads );
+	_cfg->get( "ponder", _ponder, _ponder ); // search on the player's time
+	// clocks: "" = search_time per move, "300" = sudden death, "300+2" = increment
+	_cfg->get( "time_control", temp, "" );
+	string time_control( temp );
+	free( temp );
+	if ( _args.timeControl.size() )
+		time_control = _args.timeControl; // overrule by cmd line arg
+	if ( time_control.size() && !_clock[1].parse( time_control ) )
+		DBG( "invalid time control '" << time_control << "'" );
+	_clock[2] = _clock[1];
+	// opening book (from gomoku-book), used if present
+	_cfg->get( "book", temp, "book.bin" );
+	string book_file( temp );
+	free( temp );
+	if ( _args.bookFile.size() )
+		book_file = _args.bookFile; // overrule by cmd line arg
+	if ( book_file.size() && book_file[0] != '/' && !std::filesystem::exists( book_file ) )
+		book_file = homeDir() + book_file;
+	std::shared_ptr<Book> book = std::make_shared<Book>();
+	if ( book->load( book_file ) )
+	{
+		_engine.book( book );
+		DBG( "book: " << book_file << " (" << book->entries() << " entries)" );
+	}
+	// endgame database (from gomoku-egdb), used if present
+	_cfg->get( "endgame", temp, "egdb.bin" );
+	string egdb_file( temp );
+	free( temp );
+	if ( _args.egdbFile.size() )
+		egdb_file = _args.egdbFile; // overrule by cmd line arg
+	if ( egdb_file.size() && egdb_file[0] != '/' && !std::filesystem::exists( egdb_file ) )
+		egdb_file = homeDir() + egdb_file;
+	std::shared_ptr<EndgameDB> egdb = std::make_shared<EndgameDB>();
+	if ( egdb->load( egdb_file ) )
+	{
+		_engine.endgame( egdb );
+		DBG( "endgame database: " << egdb_file << " (" << egdb->entries() << " entries)" );
+	}
+	// evaluation weights (from gomoku-tune), used if present
+	_cfg->get( "weights", temp, "weights.txt" );
+	string weights_file( temp );
+	free( temp );
+	if ( _args.weightsFile.size() )
+		weights_file = _args.weightsFile; // overrule by cmd line arg
+	if ( weights_file.size() && weights_file[0] != '/' && !std::filesystem::exists( weights_file ) )
+		weights_file = homeDir() + weights_file;
+	Weights weights;
+	if ( weights.load( weights_file ) )
+	{
+		_engine.weights( weights );
+		DBG( "weights: " << weights_file );
+	}
 
 	DBG( "homeDir: " << homeDir() );
 
@@ -670,26 +592,14 @@ void Gomoku::onNextMove()
 	if ( _replay )
 	{
 		replayInfoMessage();
-		if ( !waitKey() )
-			return;
-		if ( !_replay ) // "play from here" selected
-			return nextMove();
-
-		default_cursor( FL_CURSOR_WAIT );
-		_move.init();
-		if ( !_abort && _history.size() < _replayMoves.size() )
-		{
-			_move = _replayMoves[ _history.size() ];
-			if ( !_player )
-				_move.value = eval( _move );
-		}
-		Fl::add_timeout( .1, cb_move, this );
-		return;
+		return waitKey( &Gomoku::onReplayKey );
 	}
 	if ( _player && !_autoplay )
 	{
 		message( yourMovePrompt() );
 		default_cursor( FL_CURSOR_HAND );
+		startClock( PLAYER );
+		startPonder();
 	}
 	else
 	{
@@ -701,19 +611,52 @@ void Gomoku::onNextMove()
 			_player = !_player;
 		}
 		message( "Thinking..." );
+		startClock( COMPUTER );
 		makeMove();
 	}
 }
 
+void Gomoku::onReplayKey()
+//-------------------------------------------------------------------------------
+{
+	if ( !_replay ) // "play from here" selected
+		return nextMove();
+
+	default_cursor( FL_CURSOR_WAIT );
+	_move.init();
+	if ( !_abort && _history.size() < _replayMoves.size() )
+	{
+		_move = _replayMoves[ _history.size() ];
+		if ( !_player )
+			_move.value = _engine.eval( _move, COMPUTER );
+	}
+	Fl::add_timeout( .1, cb_move, this );
+}
+
 Gomoku::~Gomoku()
 //-------------------------------------------------------------------------------
 {
+	_searchAbort = true;
+	if ( _searchThread.joinable() )
+		_searchThread.join();
 	_cfg->set( "W", w() );
 	_cfg->set( "X", x() );
 	_cfg->set( "Y", y() );
 
 	_cfg->set( "debug", _debug );
 	_cfg->set( "alert", _alert );
+	_cfg->set( "search_time", _engine.searchTime() );
+	_cfg->set( "hash_size", _hashSize );
+	_cfg->set( "threads", _engine.threads() );
+	_cfg->set( "ponder", _ponder );
+	ostringstream time_control;
+	if ( _clock[1].mode() != TimeControl::TC_Move )
+	{
+		time_control << _clock[1].time();
+		if ( _clock[1].mode() == TimeControl::TC_Increment )
+			time_control << "+" << _clock[1].increment();
+	}
+	_cfg->set( "time_control", time_control.str().c_str() );
 	_cfg->flush();
 }
 
@@ -743,6 +686,31 @@ void Gomoku::parseArgs( int argc_, char *argv_[] )
 			if ( ++i < argc_ )
 				_args.boardSize = argv_[i];
 		}
+		else if ( arg == "-seed" )
+		{
+			if ( ++i < argc_ )
+				_args.seed = strtoull( argv_[i], 0, 10 );
+		}
+		else if ( arg == "-book" )
+		{
+			if ( ++i < argc_ )
+				_args.bookFile = argv_[i];
+		}
+		else if ( arg == "-egdb" )
+		{
+			if ( ++i < argc_ )
+				_args.egdbFile = argv_[i];
+		}
+		else if ( arg == "-weights" )
+		{
+			if ( ++i < argc_ )
+				_args.weightsFile = argv_[i];
+		}
+		else if ( arg == "-tc" )
+		{
+			if ( ++i < argc_ )
+				_args.timeControl = argv_[i];
+		}
 		else if ( arg[0] != '-' )
 		{
 			_args.bgImageFile = argv_[i];
@@ -753,10 +721,7 @@ void Gomoku::parseArgs( int argc_, char *argv_[] )
 void Gomoku::clearBoard()
 //-------------------------------------------------------------------------------
 {
-	memset( _board, -1, sizeof( _board ) );
-	for ( int x = 1; x <= _BS; x++ )
-		for ( int y = 1; y <= _BS; y++ )
-			_board[x][y] = 0;
+	_engine.clearBoard();
 	_history.clear();
 	if ( _args.boardFile.size() )
 	{
@@ -790,61 +755,18 @@ bool Gomoku::loadBoardFromString( const char *s_ )
 bool Gomoku::loadBoard( istream& is_ )
 //-------------------------------------------------------------------------------
 {
-	int y = 0;
 	int last_moved = 0;
 	Move last_move;
-	string line;
-	while ( getline( is_, line ) )
-	{
-		if ( y ) // skip first line (labels)
-		{
-			if ( (int)line.size() < 2 * ( _BS ) + 1 ) break;
-			for ( int x = 1; x <= _BS; x++ )
-			{
-				char c = line[ x * 2];
-				if ( c == 'p' || c == 'P' )
-					_board[x][y] = PLAYER;
-				if ( c == 'c' || c == 'C' )
-					_board[x][y] = COMPUTER;
-				if ( c == 'P' || c == 'C' )
-				{
-					last_move.init( x, y );
-				}
-				if ( c == 'P' )
-					last_moved = PLAYER;
-				if ( c == 'C' )
-					last_moved = COMPUTER;
-			}
-		}
-		if ( ++y > _BS ) break;
-	}
+	bool complete = _engine.loadBoard( is_, PLAYER, last_moved, last_move );
 	_player = last_moved == COMPUTER;
 	_move = last_move;
-	return y >= _BS;
+	return complete;
 }
 
 std::ostream& Gomoku::dumpBoard( std::ostream& os_/* = std::cout*/ ) const
 //-------------------------------------------------------------------------------
 {
-	os_ << " ";
-	for ( int x = 1; x <= _BS; x++ )
-		os_ << " " << (char)('a' + x - 1);
-	os_ << endl;
-	for ( int y = 1; y <= _BS; y++ )
-	{
-		os_ << (char)('A' + y - 1) << " ";
-		for ( int x = 1; x <= _BS; x++ )
-		{
-			int who = _board[x][y];
-			bool last = x == _move.x && y == _move.y;
-			char player = last ? 'P' : 'p';
-			char computer = last ? 'C' : 'c';
-			os_ << ( who ? ( who == PLAYER ? player  : computer ) : '.' ) << ' ';
-		}
-		os_ << endl;
-	}
-	os_ << endl;
-	return os_;
+	return _engine.dumpBoard( os_, _move, PLAYER );
 }
 
 void Gomoku::saveBoardToFile( const string& f_ ) const
@@ -871,7 +793,7 @@ void Gomoku::loadGame( const string& f_ )
 		if ( m[0] == '#' ) // skips '-' (player did not begin)
 		{
 			Move move( m );
-			_board[ move.x ][ move.y ] = who;
+			_engine.setPiece( move.x, move.y, who );
 			_move = move;
 			_history.push_back( move );
 		}
@@ -885,7 +807,9 @@ void Gomoku::loadGame( const string& f_ )
 		// (so everything else is setup correctly)
 		Move move = _history.back();
 		_history.pop_back();
-		setPiece( move, _board[move.x][move.y] );
+		int who = _engine.at( move.x, move.y );
+		_engine.removePiece( move.x, move.y );
+		setPiece( move, who );
 	}
 	else
 	{
@@ -897,19 +821,7 @@ void Gomoku::loadGame( const string& f_ )
 std::ostream& Gomoku::dumpGame( std::ostream& os_/* = std::cout*/ ) const
 //-------------------------------------------------------------------------------
 {
-	for ( size_t i = 0; i < _history.size(); i++ )
-	{
-		Move move( _history[i] );
-		int who = _board[move.x][move.y];
-		if ( who == COMPUTER && i == 0 )
-			os_ << "-\t";
-		os_ << move.asString();
-		if ( who == PLAYER )
-			os_ << "\t";
-		else
-			os_ << endl;
-	}
-	return os_;
+	return _engine.dumpGame( os_, _history, PLAYER );
 }
 
 void Gomoku::saveGame( const string& f_ ) const
@@ -975,7 +887,7 @@ void Gomoku::drawPiece( int color_, int x_, int y_ ) const
 	svg_piece->draw( x - rw / 2, y - rh / 2 );
 
 	// highlight piece(s)
-	bool winning_piece = checkWin( x_, y_ );
+	bool winning_piece = _engine.checkWin( x_, y_ );
 	bool last_piece = _lastMove.x == x_ && _lastMove.y == y_;
 	if ( last_piece || winning_piece )
 	{
@@ -1002,206 +914,215 @@ void Gomoku::onMove()
 		setPiece( _move, _player ? PLAYER : COMPUTER );
 }
 
-bool Gomoku::randomMove( Move& move_ ) const
+void Gomoku::makeMove()
 //-------------------------------------------------------------------------------
 {
-	vector<Move> moves;
-	int r( 0 );
-	for ( int x = 1; x <= _BS; x++ )
+	// Start the search in a thread and return to the event loop.
+	// The move is made when the search is done (onSearchDone()).
+	if ( _pondering && _ponderWho == COMPUTER )
 	{
-		for ( int y = 1; y <= _BS; y++ )
+		// (the same position: not reached again after a take back)
+		bool hit = !_history.empty() && _history.back().x == _ponderMove.x &&
+		           _history.back().y == _ponderMove.y && _engine.hash() == _ponderKey;
+		_ponderCount++;
+		_ponderHits += hit;
+		DBG( "ponder " << ( hit ? "hit" : "miss" ) << " (predicted " << _ponderMove << "), hit rate " <<
+		     _ponderHits << "/" << _ponderCount << " (" << 100 * _ponderHits / _ponderCount << "%)" );
+		if ( hit )
 		{
-			if ( _board[x][y] == 0 )
-			{
-				int R = _BS / 3;
-				if ( x > R && x <= _BS - R &&
-				     y > R && y <= _BS - R )
-				{
-					moves.insert( moves.begin(), Move( x, y ) );
-					r++;
-				}
-				else
-					moves.push_back( Move( x, y ) );
-			}
+			// the ponder search becomes the search for the move:
+			// use its result when it had the normal search time
+			_pondering = false;
+			_searching = true;
+			_searchId = _ponderId;
+			if ( _ponderDone )
+				return finishMove();
+			default_cursor( FL_CURSOR_WAIT );
+			double elapsed = std::chrono::duration<double>( std::chrono::steady_clock::now() - _ponderStart ).count();
+			double remaining = moveTime() - elapsed;
+			if ( remaining <= 0 )
+				_searchAbort = true;
+			else
+				Fl::add_timeout( remaining, cb_stop_search, this );
+			return;
 		}
 	}
-	if ( moves.empty() )
-		return false;
-	if ( !r )
-		r = moves.size();
-	r = rand() % r;
-	move_ = moves[r];
-	return true;
-} // randomMove
+	stopPonder();
+	_searching = true;
+	_searchId = ++_nextId;
+	default_cursor( FL_CURSOR_WAIT );
 
-void Gomoku::makeMove()
+	// search on a copy of the engine, so the board can be drawn meanwhile
+	std::shared_ptr<Engine> engine = std::make_shared<Engine>( _engine );
+	engine->searchTime( moveTime() );
+	startSearch( engine, COMPUTER, _searchId );
+}
+
+void Gomoku::startPonder()
 //-------------------------------------------------------------------------------
 {
+	// search the answer to the predicted move of the player (from the
+	// hash table or the best greedy move) while the player thinks
+	stopPonder();
+	if ( !_ponder || _engine.searchTime() <= 0 || _engine.full() )
+		return;
+	Move predicted;
+	if ( !_engine.hashMove( predicted, PLAYER ) && !_engine.greedyMove( predicted, PLAYER ) )
+		return;
 	_pondering = true;
-	default_cursor( FL_CURSOR_WAIT );
-	Fl::add_timeout( 1.0, cb_ponder, this );
-	Move move;
-	if ( !findMove( move ) )
-	{
-		randomMove( move );
-		DBG( "randomMove at " << move );
-	}
-	while ( shown() && _pondering )
-		Fl::check();
-	fl_cursor( FL_CURSOR_ARROW );
-	_pondering = false;
-	Fl::remove_timeout( cb_ponder, this );
-	_move = move;
-	onMove();
+	_ponderDone = false;
+	_ponderWho = COMPUTER;
+	_ponderMove = predicted;
+	_ponderId = ++_nextId;
+	_ponderStart = std::chrono::steady_clock::now();
+	std::shared_ptr<Engine> engine = std::make_shared<Engine>( _engine );
+	engine->setPiece( predicted.x, predicted.y, PLAYER );
+	_ponderKey = engine->hash();
+	// (search longer than for a normal move, the result is used when ready)
+	engine->searchTime( 10 * moveTime() );
+	DBG( "pondering on " << predicted );
+	startSearch( engine, COMPUTER, _ponderId );
 }
 
-int Gomoku::count( int x_, int y_, int dx_, int dy_, PosInfo& info_ ) const
+void Gomoku::stopPonder()
 //-------------------------------------------------------------------------------
 {
-	return ::count( x_, y_, dx_, dy_, info_, _board );
+	// discard the ponder search
+	if ( !_pondering )
+		return;
+	_searchAbort = true;
+	_pondering = false;
+	_ponderId = 0;
 }
 
-void Gomoku::countPos( int x_, int y_, Eval &pos_, const Board &board_ ) const
+void Gomoku::startSearch( std::shared_ptr<Engine> engine_, int who_, int id_ )
 //-------------------------------------------------------------------------------
 {
-	::count( x_, y_,  1,  0, pos_.info[1], board_ );
-	::count( x_, y_,  0,  1, pos_.info[2], board_ );
-	::count( x_, y_, -1, -1, pos_.info[3], board_ );
-	::count( x_, y_,  1, -1, pos_.info[4], board_ );
+	if ( _searchThread.joinable() )
+		_searchThread.join(); // (a discarded search still running)
+	Fl::remove_timeout( cb_stop_search, this );
+	_searchAbort = false;
+	_threadId = id_;
+	engine_->abort( &_searchAbort );
+	_engine.jump(); // the next copy gets other random numbers
+	_searchThread = std::thread( [this, engine_, who_, id_]()
+	{
+		Move move;
+		bool random = !engine_->findMove( move, who_ );
+		if ( random )
+			engine_->randomMove( move );
+		Fl::awake( cb_search_done, new SearchResult{ this, id_, move, random } );
+	} );
 }
 
-void Gomoku::countPos( int x_, int y_, Eval &pos_ ) const
+void Gomoku::onSearchDone( int id_, const Move& move_, bool random_ )
 //-------------------------------------------------------------------------------
 {
-	countPos( x_, y_, pos_, _board );
+	if ( random_ )
+		DBG( "randomMove at " << move_ );
+	if ( id_ == _threadId && _searchThread.joinable() )
+		_searchThread.join();
+	if ( _pondering && id_ == _ponderId )
+	{
+		// keep the result until the player has moved
+		_ponderDone = true;
+		_searchMove = move_;
+		return;
+	}
+	if ( !_searching || id_ != _searchId )
+		return; // search was cancelled
+	_searchMove = move_;
+	finishMove();
 }
 
-void Gomoku::countPos( Move& move_, const Board &board_ ) const
+void Gomoku::onStopSearch()
 //-------------------------------------------------------------------------------
 {
-	countPos( move_.x, move_.y, move_.eval, board_ );
+	// search time is over (result follows with onSearchDone())
+	_searchAbort = true;
 }
 
-bool Gomoku::checkWin( int x_, int y_ ) const
+void Gomoku::finishMove()
 //-------------------------------------------------------------------------------
 {
-	Eval e;
-	countPos( x_, y_, e );
-	return e.wins();
+	_searching = false;
+	fl_cursor( FL_CURSOR_ARROW );
+	_move = _searchMove;
+	onMove();
 }
 
-bool Gomoku::findMove( Move& move_ ) const
+void Gomoku::cancelSearch()
 //-------------------------------------------------------------------------------
 {
-	vector<Move> moves;
-	for ( int x = 1; x <= _BS; x++ )
-	{
-		for ( int y = 1; y <= _BS; y++ )
-		{
-			if ( _board[x][y] == 0 )
-			{
-				Move move( x, y );
-				int value = eval( move );
-				if ( value)
-					moves.push_back( move );
-			}
-		}
-	}
-	DBG( moves.size() << " moves evaluated" );
-	if ( moves.empty() )
-		return false;
-
-	int max_value = 0;
-	vector<Move> equal;
-	for ( size_t i = 0; i < moves.size(); i++ )
-	{
-		if ( moves[i].value > max_value )
-		{
-			equal.clear();
-			max_value = moves[i].value;
-			equal.push_back( moves[i] );
-		}
-		else if ( moves[i].value == max_value )
-		{
-			equal.push_back( moves[i] );
-		}
-	}
-	DBG( equal.size() << " moves with value " << max_value );
-	for ( size_t i = 0; i < equal.size(); i++ )
-		DBG( "\t" << equal[i] );
-	int move = rand() % equal.size();
-	move_ = equal[move];
-	return true;
-} // findMove
+	// discard the result of a running search
+	// (the thread is joined when it has finished)
+	stopPonder();
+	_searchAbort = true;
+	_searching = false;
+	_searchId = 0;
+	Fl::remove_timeout( cb_stop_search, this );
+}
 
-int Gomoku::evaluate( Move& m_, int who_ ) const
+double Gomoku::clockTime( int who_ ) const
 //-------------------------------------------------------------------------------
 {
-	Board board;
-	memcpy( &board, &_board, sizeof( board ) );
-	board[m_.x][m_.y] = who_;
-	countPos( m_, board );
-	const char *who = who_ == COMPUTER ? "COMPUTER" : "PLAYER";
-
-	if ( m_.eval.wins() )
-	{
-		m_.value += 100000;
-		DBG( "eval " << who <<  " wins at " << m_ );
-	}
-
-	if ( m_.eval.has4() )
-	{
-		m_.value += m_.eval.has4() * 10000;
-		DBG( "eval has4 " << who << " at " << m_ );
-	}
-
-	if ( m_.eval.has3Fork() )
-	{
-		m_.value += m_.eval.has3Fork() * 1000;
-		DBG( "eval has3Fork " << who << " at " << m_ );
-	}
-
-	if ( m_.eval.has3nogap() )
-	{
-		m_.value += m_.eval.has3() * 200;
-		DBG( "eval has3nogap " << who << " at " << m_ );
-	}
-
-	if ( m_.eval.has3() )
-	{
-		m_.value += m_.eval.has3() * 50;
-		DBG( "eval has3 " << who << " at " << m_ );
-	}
-
-	if ( m_.eval.has2() )
-	{
-		m_.value += m_.eval.has2() * 10;
-		DBG( "eval has2 " << who << " at " << m_ );
-	}
+	// remaining time of who_ (including the running move)
+	double t = _clock[who_].remaining();
+	if ( who_ == _clockWho )
+		t -= std::chrono::duration<double>( std::chrono::steady_clock::now() - _clockStart ).count();
+	return t;
+}
 
-	return m_.value;
+double Gomoku::moveTime() const
+//-------------------------------------------------------------------------------
+{
+	// search time for the computer's move
+	if ( _clock[COMPUTER].mode() == TimeControl::TC_Move )
+		return _engine.searchTime();
+	return _clock[COMPUTER].budget( _engine.pieces(), _BS );
 }
 
-int Gomoku::eval( Move& move_ ) const
+void Gomoku::startClock( int who_ )
 //-------------------------------------------------------------------------------
 {
-	Move mc( move_.x, move_.y );
-	evaluate( mc, COMPUTER );
-	if ( mc.eval.wins() )
-		mc.value *= 10; // don't miss winning move!
-	else if ( mc.value ) // always just raise computer move above equal player move
-		mc.value += 1;
+	if ( _clock[who_].mode() == TimeControl::TC_Move || _clockWho == who_ )
+		return; // (keeps running e.g. after taking back moves)
+	stopClock();
+	_clockWho = who_;
+	_clockStart = std::chrono::steady_clock::now();
+	Fl::add_timeout( 0.1, cb_clock, this );
+}
 
-	Move mp( move_.x, move_.y );
-	evaluate( mp, PLAYER );
+void Gomoku::stopClock()
+//-------------------------------------------------------------------------------
+{
+	// the move is made: charge its time to the clock
+	if ( !_clockWho )
+		return;
+	Fl::remove_timeout( cb_clock, this );
+	_clock[_clockWho].used( std::chrono::duration<double>( std::chrono::steady_clock::now() - _clockStart ).count() );
+	_clockWho = 0;
+	redraw();
+}
 
-	move_.value = mc.value + mp.value;
-	if ( move_.value )
-	{
-		DBG( move_ << " (combined)" );
-	}
-	return move_.value;
-} // eval
+void Gomoku::onClock()
+//-------------------------------------------------------------------------------
+{
+	int who = _clockWho;
+	if ( !who )
+		return;
+	redraw();
+	if ( clockTime( who ) > 0 )
+		return Fl::repeat_timeout( 0.1, cb_clock, this );
+	// flag fall: the side to move loses
+	DBG( ( who == PLAYER ? "player" : "computer" ) << " lost on time" );
+	stopClock();
+	cancelSearch();
+	fl_cursor( FL_CURSOR_ARROW );
+	_timeLoss = true;
+	_player = !_player; // (as if the winner had moved last)
+	gameFinished( 3 - who );
+}
 
 void Gomoku::updateGameStats( int winner_ )
 //-------------------------------------------------------------------------------
@@ -1237,7 +1158,7 @@ void Gomoku::finishedMessage( int winner_ )
 	{
 		msg << ( !winner_ ? "No more moves!\n\nGame ends adraw." :
 		         winner_ == PLAYER ? "You managed to win!" : "FLTK wins!" ) <<
-		         endl << endl;
+		         ( _timeLoss ? "\n(on time)" : "" ) << endl << endl;
 	}
 	msg << stat.str();
 	DBG( msg.str() );
@@ -1258,6 +1179,7 @@ void Gomoku::gameFinished( int winner_ )
 {
 	// this game is finished, either by adraw or someone has won.
 	// (winner_ will be 0 if adraw, otherwise PLAYER or COMPUTER)
+	stopPonder();
 	if ( !_replay )
 	{
 		if ( _debug )
@@ -1275,15 +1197,27 @@ void Gomoku::gameFinished( int winner_ )
 #else
 	fl_beep( FL_BEEP_MESSAGE );
 #endif
-	wait( 0.5 );
+	// show the message after a short delay
+	_winner = winner_;
+	Fl::remove_timeout( cb_game_finished, this );
+	Fl::add_timeout( 0.5, cb_game_finished, this );
+}
 
+void Gomoku::onGameFinished()
+//-------------------------------------------------------------------------------
+{
+	if ( !shown() )
+		return;
 	// prepare/show the right message
-	finishedMessage( winner_ );
+	finishedMessage( _winner );
 
 	// wait for a key (click)
-	if ( !waitKey() )
-		return;
+	waitKey( &Gomoku::onGameFinishedKey );
+}
 
+void Gomoku::onGameFinishedKey()
+//-------------------------------------------------------------------------------
+{
 	// query for replay
 	if ( !( _replay = fl_choice( "Do you want to replay\nthe game?", "NO" , "YES", 0 ) ) )
 		_args.boardFile.erase(); // use pre-loaded board only once (but keep for replay)!
@@ -1306,6 +1240,7 @@ void Gomoku::setPiece( const Move& move_, int who_ )
 	// update move counter
 	if ( !_replay )
 		_moves++;
+	stopClock();
 
 	// show value of move if in debug mode
 	if ( _debug && move_.x )
@@ -1321,7 +1256,7 @@ void Gomoku::setPiece( const Move& move_, int who_ )
 	{
 		_history.push_back( move_ );
 		_move = move_;
-		_board[ move_.x ][ move_.y ] = who_;
+		_engine.setPiece( move_.x, move_.y, who_ );
 #ifdef USE_MINIAUDIO
 		_audio.play( homeDir() + "rsc/move.mp3" );
 #endif
@@ -1332,14 +1267,11 @@ void Gomoku::setPiece( const Move& move_, int who_ )
 
 	// check for board full *after* move
 	if ( _player )
-	{
-		Move move;
-		adraw = !randomMove( move ); // try a move - will fail if board full
-	}
+		adraw = _engine.full();
 	if ( _debug )
 		dumpBoard( *_logStream );
 
-	if ( adraw || checkWin( move_.x, move_.y ) )
+	if ( adraw || _engine.checkWin( move_.x, move_.y ) )
 	{
 		return gameFinished( adraw ? 0 : who_ );
 	}
@@ -1349,32 +1281,33 @@ void Gomoku::setPiece( const Move& move_, int who_ )
 	nextMove();
 } // setPiece
 
-void Gomoku::onDelay()
+void Gomoku::waitKey( void (Gomoku::*then_)() )
 //-------------------------------------------------------------------------------
 {
-	_waiting = false;
+	// continue with then_ when a key (click) is pressed (see keyPressed())
+	_onKey = then_;
+	if ( _abort )
+		return keyPressed();
+	_wait_click = true;
+	default_cursor( FL_CURSOR_MOVE );
 }
 
-void Gomoku::wait( double delay_ )
+void Gomoku::keyPressed()
 //-------------------------------------------------------------------------------
 {
-	Fl::remove_timeout( cb_delay, this );
-	Fl::add_timeout( delay_, cb_delay, this );
-	_waiting = true;
-	while ( shown() && _waiting )
-		Fl::check();
-	Fl::remove_timeout( cb_delay, this );
-	_waiting = false;
+	// (continuation is called from the event loop, not from within handle())
+	_wait_click = false;
+	Fl::remove_timeout( cb_key, this );
+	Fl::add_timeout( 0.0, cb_key, this );
 }
 
-bool Gomoku::waitKey()
+void Gomoku::onKey()
 //-------------------------------------------------------------------------------
 {
-	_wait_click = true;
-	default_cursor( FL_CURSOR_MOVE );
-	while ( shown() && _wait_click && !_abort )
-		Fl::check();
-	return shown();
+	void (Gomoku::*then)() = _onKey;
+	_onKey = 0;
+	if ( then && shown() )
+		(this->*then)();
 }
 
 void Gomoku::initPlay()
@@ -1384,11 +1317,18 @@ void Gomoku::initPlay()
 	_dmsg.erase();
 	_move.init();
 	_wait_click = false;
+	_onKey = 0;
 	_abort = false;
+	cancelSearch();
+	stopClock();
+	_clock[1].reset();
+	_clock[2].reset();
+	_timeLoss = false;
+	Fl::remove_timeout( cb_game_finished, this );
 	if ( _history.size() )
 	{
 		Move first_move = _history[0];
-		_player = _board[ first_move.x ][ first_move.y ] == PLAYER;
+		_player = _engine.at( first_move.x, first_move.y ) == PLAYER;
 	}
 	clearBoard();
 	redraw();
@@ -1546,8 +1486,9 @@ void Gomoku::onMenu( void *d_ )
 	else if ( d_ == &_abortReplay || d_ == &_playReplay )
 	{
 		_abort = true;
-		_wait_click = false;
 		_replay = d_ == &_abortReplay;
+		if ( _wait_click )
+			keyPressed();
 	}
 }
 
@@ -1556,7 +1497,7 @@ Move Gomoku::getMoveFromMousePosition() const
 {
 	int x = ( Fl::event_x() + xp( 1 ) / 2 ) / xp( 1 );
 	int y = ( Fl::event_y() + yp( 1 ) / 2 ) / yp( 1 );
-	if ( x >= 1 && x <= _BS && y >= 1 && y <= _BS && _board[x][y] == 0 )
+	if ( x >= 1 && x <= _BS && y >= 1 && y <= _BS && _engine.at( x, y ) == 0 )
 		return Move( x, y );
 	return Move();
 }
@@ -1606,9 +1547,9 @@ int Gomoku::handleWaitClickEvent( int e_ )
 	     ( e_ == FL_KEYDOWN && ( Fl::event_key( ' ' ) ||
 	                             Fl::event_key( FL_Escape ) ) ) )
 	{
-		_wait_click = false;
 		if ( Fl::event_key( FL_Escape ) )
 			_abort = true;
+		keyPressed();
 		return 1;
 	}
 	else if ( _replay && e_ == FL_KEYDOWN && Fl::event_key( FL_BackSpace ) )
@@ -1623,32 +1564,35 @@ void Gomoku::showPositionValue()
 //-------------------------------------------------------------------------------
 {
 	Move move = getMoveFromMousePosition();
-	if ( !move.valid() || _board[ move.x ][ move.y ] != 0 )
+	if ( !move.valid() || _engine.at( move.x, move.y ) != 0 )
 	{
 		dmsg( "" );
 		return;
 	}
-	int debug = _debug;
-	_debug = 0; // do not create log messages in evaluation
+	_engine.debug( 0 ); // do not create log messages in evaluation
 	ostringstream os;
-	eval( move );
+	_engine.eval( move, COMPUTER );
 	os <<  move;
 	dmsg( os.str() );
-	_debug = debug;
+	_engine.debug( _debug );
 }
 
 /*virtual */
 int Gomoku::handle( int e_ )
 //-------------------------------------------------------------------------------
 {
-	if ( e_ == FL_HIDE ) // window closed, don't block exit!
+	if ( e_ == FL_HIDE ) // window closed, stop waiting
+	{
 		_wait_click = false;
+		_onKey = 0;
+	}
 
 	// debug toggle is always allowed
 	if ( e_ == FL_KEYDOWN && Fl::event_key( 'd' ) )
 	{
 		_debug++;
 		_debug &= 3; // [0, 3]
+		_engine.debug( _debug );
 		dmsg( "" );
 		std::cout << "debug " << _debug << endl;
 	}
@@ -1726,11 +1670,12 @@ bool Gomoku::takeBackMove()
 //-------------------------------------------------------------------------------
 {
 	// restore game to state of previous move
+	stopPonder(); // (searched on the position before the take back)
 	if ( _history.size() )
 	{
 		Move move = _history.back();
 		_history.pop_back();
-		_board[ move.x ][ move.y ] = 0;
+		_engine.removePiece( move.x, move.y );
 		_player = !_player;
 		move.init();
 		if ( _history.size() )
@@ -1747,6 +1692,7 @@ bool Gomoku::takeBackMove()
 bool Gomoku::takeBackMoves()
 //-------------------------------------------------------------------------------
 {
+	stopPonder();
 	if ( !takeBackMove() )
 		return true;
 	return takeBackMove();
@@ -1853,9 +1799,9 @@ void Gomoku::draw()
 	{
 		for ( int y = 1; y <= _BS; y++ )
 		{
-			if ( _board[x][y] )
+			if ( _engine.at( x, y ) )
 			{
-				drawPiece( _board[x][y], x, y );
+				drawPiece( _engine.at( x, y ), x, y );
 			}
 		}
 	}
@@ -1872,6 +1818,19 @@ void Gomoku::draw()
 			FL_ALIGN_CENTER | FL_ALIGN_TOP, 0, 0 );
 	}
 
+	// draw clocks (running one highlighted) in the top margin
+	if ( _clock[PLAYER].mode() != TimeControl::TC_Move )
+	{
+		fl_font( FL_HELVETICA|FL_BOLD, xp( 1 ) / 3 );
+		for ( int who = 1; who <= 2; who++ )
+		{
+			string clock = string( who == PLAYER ? "You " : "FLTK " ) + TimeControl::format( clockTime( who ) );
+			fl_color( who == _clockWho ? FL_YELLOW : FL_WHITE );
+			fl_draw( clock.c_str(), xp( 1 ), 0, xp( _BS - 1 ), yp( 1 ) / 2,
+				( who == PLAYER ? FL_ALIGN_LEFT : FL_ALIGN_RIGHT ), 0, 0 );
+		}
+	}
+
 	if ( _dmsg.size() )
 	{
 		fl_color( FL_WHITE );
@@ -1889,7 +1848,7 @@ int main( int argc_, char *argv_[] )
 	Fl::get_system_colors();
 	Fl::background( 240, 240, 240 );
 	fl_register_images();
-	srand( time( 0 ) );
+	Fl::lock(); // enable Fl::awake() for the search thread
 	try
 	{
 		Gomoku g( argc_, argv_ );
@@ -0,0 +1,265 @@
+/*
+
+ FLTK Gomoku - binary game file
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "gamefile.h"
+#include "engine.h"
+#include <cstring>
+
+using namespace std;
+
+static const char MAGIC[8] = { 'G', 'M', 'K', 'G', 'A', 'M', 'E', '1' };
+static const char INDEX_MAGIC[8] = { 'G', 'M', 'K', 'I', 'N', 'D', 'X', '1' };
+
+enum RecordFlags
+{
+	RF_Position = 1,
+	RF_OtherBegan = 2,
+	RF_LastMove = 4
+};
+
+static const int ESCAPE = 255; // (cells from 255 on take two bytes)
+
+GameFile::GameFile() :
+	_header( 0 ),
+	_index( 0 ),
+	_count( 0 ),
+	_end( 0 )
+//-------------------------------------------------------------------------------
+{
+}
+
+void GameFile::close()
+//-------------------------------------------------------------------------------
+{
+	_file.close();
+	_header = 0;
+	_index = 0;
+	_count = 0;
+	_end = 0;
+}
+
+bool GameFile::open( const string& file_ )
+//-------------------------------------------------------------------------------
+{
+	close();
+	_file.open( file_ );
+	const char *data = _file.data();
+	size_t bytes = _file.size();
+	const Header *header = reinterpret_cast<const Header *>( data );
+	if ( !data || bytes < sizeof( Header ) || memcmp( header->magic, MAGIC, sizeof( MAGIC ) ) ||
+	     header->size < 5 || header->size > Engine::BS_Max )
+	{
+		close();
+		return false;
+	}
+	_header = header;
+	_end = bytes;
+	// index at the end?
+	size_t trailer = 2 * sizeof( uint64_t );
+	if ( bytes >= sizeof( Header ) + trailer &&
+	     !memcmp( data + bytes - sizeof( INDEX_MAGIC ), INDEX_MAGIC, sizeof( INDEX_MAGIC ) ) )
+	{
+		uint64_t count;
+		memcpy( &count, data + bytes - trailer, sizeof( count ) );
+		if ( count > ( bytes - sizeof( Header ) - trailer ) / sizeof( uint64_t ) )
+		{
+			close();
+			return false;
+		}
+		_end = bytes - trailer - count * sizeof( uint64_t );
+		_index = reinterpret_cast<const uint64_t *>( data + _end );
+		_count = count;
+	}
+	return true;
+}
+
+size_t GameFile::count() const
+//-------------------------------------------------------------------------------
+{
+	if ( _index )
+		return _count;
+	size_t n = 0;
+	size_t offset = first();
+	const char *data = _file.data();
+	while ( _header && offset + sizeof( uint16_t ) <= _end )
+	{
+		uint16_t length;
+		memcpy( &length, data + offset, sizeof( length ) );
+		offset += sizeof( length ) + length;
+		if ( !length || offset > _end )
+			break;
+		n++;
+	}
+	return n;
+}
+
+bool GameFile::read( size_t& offset_, GameRecord& record_ ) const
+//-------------------------------------------------------------------------------
+{
+	// (a zero length is the padding before the index)
+	const uint8_t *data = reinterpret_cast<const uint8_t *>( _file.data() );
+	uint16_t length;
+	if ( !_header || offset_ + sizeof( length ) > _end )
+		return false;
+	memcpy( &length, data + offset_, sizeof( length ) );
+	const uint8_t *p = data + offset_ + sizeof( length );
+	const uint8_t *end = p + length;
+	if ( length < 2 || offset_ + sizeof( length ) + length > _end )
+		return false;
+	int flags = *p++;
+	record_.type = flags & RF_Position ? GameRecord::GR_Position : GameRecord::GR_Game;
+	record_.otherBegan = flags & RF_OtherBegan;
+	record_.lastMove = flags & RF_LastMove;
+	record_.result = *p++;
+	record_.first = 0;
+	if ( record_.type == GameRecord::GR_Position )
+	{
+		if ( end - p < (ptrdiff_t)sizeof( uint16_t ) )
+			return false;
+		uint16_t first;
+		memcpy( &first, p, sizeof( first ) );
+		record_.first = first;
+		p += sizeof( first );
+	}
+	int BS = _header->size;
+	record_.moves.clear();
+	while ( p < end )
+	{
+		int cell = *p++;
+		if ( cell == ESCAPE )
+		{
+			if ( p == end )
+				return false;
+			cell += *p++;
+		}
+		if ( cell >= BS * BS )
+			return false;
+		record_.moves.push_back( Move( cell % BS + 1, cell / BS + 1 ) );
+	}
+	if ( record_.first > (int)record_.moves.size() )
+		return false;
+	offset_ = end - data;
+	return true;
+}
+
+bool GameFile::record( size_t i_, GameRecord& record_ ) const
+//-------------------------------------------------------------------------------
+{
+	if ( !_index || i_ >= _count )
+		return false;
+	size_t offset = _index[i_];
+	return offset >= first() && read( offset, record_ );
+}
+
+GameWriter::GameWriter() :
+	_size( 0 ),
+	_index( true ),
+	_offset( 0 )
+//-------------------------------------------------------------------------------
+{
+}
+
+GameWriter::~GameWriter()
+//-------------------------------------------------------------------------------
+{
+	close();
+}
+
+bool GameWriter::open( const string& file_, int size_, bool index_/* = true*/ )
+//-------------------------------------------------------------------------------
+{
+	close();
+	if ( size_ < 5 || size_ > Engine::BS_Max )
+		return false;
+	_ofs.open( file_.c_str(), ios::binary | ios::trunc );
+	if ( !_ofs.is_open() )
+		return false;
+	_size = size_;
+	_index = index_;
+	_offsets.clear();
+	GameFile::Header header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, MAGIC, sizeof( MAGIC ) );
+	header.size = size_;
+	_ofs.write( reinterpret_cast<const char *>( &header ), sizeof( header ) );
+	_offset = sizeof( header );
+	return _ofs.good();
+}
+
+bool GameWriter::write( const GameRecord& record_ )
+//-------------------------------------------------------------------------------
+{
+	if ( !_ofs.is_open() )
+		return false;
+	bool position = record_.type == GameRecord::GR_Position;
+	_buffer.resize( sizeof( uint16_t ) );
+	_buffer.push_back( ( position ? RF_Position : 0 ) | ( record_.otherBegan ? RF_OtherBegan : 0 ) |
+	                   ( record_.lastMove ? RF_LastMove : 0 ) );
+	_buffer.push_back( record_.result );
+	if ( position )
+	{
+		if ( record_.first < 0 || record_.first > (int)record_.moves.size() )
+			return false;
+		uint16_t first = record_.first;
+		const uint8_t *f = reinterpret_cast<const uint8_t *>( &first );
+		_buffer.insert( _buffer.end(), f, f + sizeof( first ) );
+	}
+	for ( size_t i = 0; i < record_.moves.size(); i++ )
+	{
+		const Move& move = record_.moves[i];
+		if ( move.x < 1 || move.x > _size || move.y < 1 || move.y > _size )
+			return false;
+		int cell = ( move.y - 1 ) * _size + move.x - 1;
+		if ( cell >= ESCAPE )
+		{
+			_buffer.push_back( ESCAPE );
+			cell -= ESCAPE;
+		}
+		_buffer.push_back( cell );
+	}
+	size_t length = _buffer.size() - sizeof( uint16_t );
+	if ( length > 0xffff )
+		return false;
+	uint16_t l = length;
+	memcpy( &_buffer[0], &l, sizeof( l ) );
+	_ofs.write( reinterpret_cast<const char *>( &_buffer[0] ), _buffer.size() );
+	_offsets.push_back( _offset );
+	_offset += _buffer.size();
+	return _ofs.good();
+}
+
+bool GameWriter::close()
+//-------------------------------------------------------------------------------
+{
+	if ( !_ofs.is_open() )
+		return false;
+	if ( _index )
+	{
+		// (the offsets aligned to 8 bytes for the reader)
+		static const char padding[sizeof( uint64_t )] = { 0 };
+		_ofs.write( padding, ( sizeof( uint64_t ) - _offset % sizeof( uint64_t ) ) % sizeof( uint64_t ) );
+		if ( _offsets.size() )
+			_ofs.write( reinterpret_cast<const char *>( &_offsets[0] ), _offsets.size() * sizeof( uint64_t ) );
+		uint64_t count = _offsets.size();
+		_ofs.write( reinterpret_cast<const char *>( &count ), sizeof( count ) );
+		_ofs.write( INDEX_MAGIC, sizeof( INDEX_MAGIC ) );
+	}
+	bool ok = _ofs.good();
+	_ofs.close();
+	return ok;
+}
@@ -0,0 +1,122 @@
+/*
+
+ FLTK Gomoku - binary game file
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#ifndef GAMEFILE_H
+#define GAMEFILE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "mappedfile.h"
+
+struct Move;
+
+// a game or a position
+struct GameRecord
+{
+	enum Type { GR_Game, GR_Position };
+	Type type = GR_Game;
+	// games: winner (0 = none, 3 = draw), positions: colour to move
+	int result = 0;
+	// games: the other colour began ('-' in the text format)
+	bool otherBegan = false;
+	// games: the moves in order, positions: the pieces of colour 1
+	// (the first `first`), then those of colour 2
+	std::vector<Move> moves;
+	int first = 0;
+	// positions: the last piece of the colour not to move was the last move
+	bool lastMove = false;
+};
+
+//-------------------------------------------------------------------------------
+class GameFile
+//-------------------------------------------------------------------------------
+{
+	// Games and positions in a compact binary file, read from the mapped
+	// file without copying it (records are decoded on request).
+	//
+	// File layout (native byte order):
+	//   Header   magic "GMKGAME1", board size, reserved (16 bytes)
+	//   Record[] length of the record (16 bit), then
+	//            flags (bit 0: position, 1: other colour began,
+	//            2: last move marked), result or colour to move,
+	//            positions: number of pieces of colour 1 (16 bit),
+	//            one byte per cell (y - 1) * size + x - 1, cells from 255
+	//            on as 255 followed by the cell - 255
+	//   Index    (optional) zero padding to 8 bytes, offset of each
+	//            record (64 bit), number of records (64 bit), "GMKINDX1"
+public:
+	struct Header
+	{
+		char magic[8];
+		uint32_t size;
+		uint32_t reserved;
+	};
+	GameFile();
+	bool open( const std::string& file_ );
+	void close();
+	bool isOpen() const { return _header != 0; }
+	int size() const { return _header ? _header->size : 0; }
+	bool indexed() const { return _index != 0; }
+	// number of records (counted without an index)
+	size_t count() const;
+	// offset of the first record, read() advances offset_ to the next
+	// (false at the end or on a damaged record)
+	size_t first() const { return sizeof( Header ); }
+	bool read( size_t& offset_, GameRecord& record_ ) const;
+	// record i_ (needs the index)
+	bool record( size_t i_, GameRecord& record_ ) const;
+private:
+	GameFile( const GameFile& );
+	GameFile& operator=( const GameFile& );
+private:
+	MappedFile _file;
+	const Header *_header;
+	const uint64_t *_index;
+	size_t _count;
+	size_t _end; // end of the records
+};
+
+//-------------------------------------------------------------------------------
+class GameWriter
+//-------------------------------------------------------------------------------
+{
+	// writes a game file (see GameFile) record by record
+public:
+	GameWriter();
+	~GameWriter();
+	bool open( const std::string& file_, int size_, bool index_ = true );
+	bool write( const GameRecord& record_ );
+	// writes the index (if any)
+	bool close();
+	size_t count() const { return _offsets.size(); }
+private:
+	GameWriter( const GameWriter& );
+	GameWriter& operator=( const GameWriter& );
+private:
+	std::ofstream _ofs;
+	int _size;
+	bool _index;
+	uint64_t _offset;
+	std::vector<uint64_t> _offsets;
+	std::vector<uint8_t> _buffer;
+};
+
+#endif // GAMEFILE_H
@@ -0,0 +1,303 @@
+/*
+
+ FLTK Gomoku - game analysis
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Analyses games in the format of the GUI's "Save game.." move by move:
+ searches every position of a game (bounded by -time and/or -depth) for
+ the engine's preferred move, scores it and the move played as root moves
+ of a search to the depth reached and reports the difference, with
+ mistakes (?) and blunders (??) marked. Games are analysed in parallel
+ (-j), the results are printed in the order of the files.
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdlib>
+#include <chrono>
+
+using namespace std;
+
+static double searchTime = 0.05;
+static int searchDepth = 0;
+static int threads = 1; // per search
+static int hashSize = 16;
+static int boardSize = Engine::BS_Standard;
+static int blunder = 20000; // score loss of a blunder (half of it a mistake)
+static uint64_t seed = 1;
+
+static const int WIN_LIMIT = Engine::WIN_SCORE - 64; // (forced win or loss)
+
+static double now()
+//-------------------------------------------------------------------------------
+{
+	return chrono::duration<double>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static bool readGame( const string& f_, vector<Move>& moves_, bool& otherBegan_ )
+//-------------------------------------------------------------------------------
+{
+	// moves of both colours alternating ('-' if the other colour began)
+	ifstream ifs( f_.c_str() );
+	if ( !ifs.is_open() )
+		return false;
+	moves_.clear();
+	otherBegan_ = false;
+	string m;
+	while ( ifs >> m )
+	{
+		if ( m[0] == '#' )
+		{
+			Move move( m );
+			if ( !move.valid() || move.x > boardSize || move.y > boardSize )
+				return false;
+			moves_.push_back( move );
+		}
+		else if ( m == "-" && moves_.empty() )
+			otherBegan_ = true;
+		else
+			return false;
+	}
+	return moves_.size() > 0;
+}
+
+static string score( int score_ )
+//-------------------------------------------------------------------------------
+{
+	return score_ >= WIN_LIMIT ? "win" : score_ <= -WIN_LIMIT ? "loss" : to_string( score_ );
+}
+
+// analysis of one move
+struct Ply
+{
+	int who = 0;
+	Move move; // played
+	Move best; // preferred by the engine
+	int bestScore = 0;
+	int score = 0; // of the move played
+	bool compared = false; // both scores by searches to the same depth
+};
+
+static string analyseGame( Engine& engine_, const string& f_ )
+//-------------------------------------------------------------------------------
+{
+	vector<Move> moves;
+	bool otherBegan;
+	if ( !readGame( f_, moves, otherBegan ) )
+		return f_ + ": no valid game\n";
+	engine_.clearBoard();
+	vector<Ply> plies;
+	int who = otherBegan ? 2 : 1;
+	int winner = 0;
+	// search each position before a move: the preferred move and the move
+	// played are scored as root moves to the depth of the search (as the
+	// scores of different depths swing between odd and even plies). Without
+	// a search (forced win, only one move) the score of the move played is
+	// the negated score of the next position.
+	for ( size_t i = 0; i <= moves.size() && !winner && !engine_.full(); i++, who = 3 - who )
+	{
+		if ( i == moves.size() && ( plies.empty() || plies.back().compared ) )
+			break;
+		Move best;
+		if ( !engine_.findMove( best, who ) && !engine_.randomMove( best ) )
+			break; // (empty board: any move, score 0)
+		if ( i && !plies.back().compared )
+		{
+			// (also of the preferred move if played, unless a forced result)
+			Ply& p = plies.back();
+			p.score = -engine_.score();
+			if ( p.move.x == p.best.x && p.move.y == p.best.y &&
+			     p.bestScore < WIN_LIMIT && p.bestScore > -WIN_LIMIT )
+				p.bestScore = p.score;
+		}
+		if ( i == moves.size() )
+			break;
+		if ( engine_.at( moves[i].x, moves[i].y ) )
+			return f_ + ": invalid move " + moves[i].asString() + "\n";
+		Ply ply;
+		ply.who = who;
+		ply.move = moves[i];
+		ply.best = best;
+		ply.bestScore = engine_.score();
+		if ( engine_.depth() )
+		{
+			// (the preferred move again, so both are scored the same way)
+			int depth = engine_.depth();
+			ply.compared = true;
+			ply.bestScore = engine_.scoreMove( best, who, depth );
+			ply.score = moves[i].x == best.x && moves[i].y == best.y ? ply.bestScore :
+			            engine_.scoreMove( moves[i], who, depth );
+		}
+		engine_.makeMove( moves[i], who );
+		if ( engine_.checkWin( moves[i].x, moves[i].y ) )
+		{
+			winner = who;
+			ply.score = Engine::WIN_SCORE;
+		}
+		plies.push_back( ply );
+	}
+
+	ostringstream os;
+	os << f_ << ": " << moves.size() << " moves, " <<
+	      ( winner ? winner == 1 ? "first player wins" : "second player wins" : "no winner" ) << endl;
+	os << "   ply  move     score  best     score     delta" << endl;
+	int mistakes[2 + 1] = { 0, 0, 0 };
+	int blunders[2 + 1] = { 0, 0, 0 };
+	long loss[2 + 1] = { 0, 0, 0 };
+	int counted[2 + 1] = { 0, 0, 0 };
+	for ( size_t i = 0; i < plies.size(); i++ )
+	{
+		const Ply& p = plies[i];
+		int side = p.who;
+		// (scores of different searches are not compared, only the forced
+		// results; the preferred move is no error)
+		bool best = p.move.x == p.best.x && p.move.y == p.best.y;
+		bool forced = p.bestScore >= WIN_LIMIT || p.bestScore <= -WIN_LIMIT ||
+		              p.score >= WIN_LIMIT || p.score <= -WIN_LIMIT;
+		bool measured = !forced && ( p.compared || best );
+		int delta = measured && !best ? p.bestScore - p.score : 0;
+		if ( delta < 0 )
+			delta = 0;
+		const char *flag = "";
+		if ( best )
+			;
+		else if ( ( p.bestScore >= WIN_LIMIT && p.score < WIN_LIMIT ) ||
+		          ( p.score <= -WIN_LIMIT && p.bestScore > -WIN_LIMIT ) || delta >= blunder )
+		{
+			flag = "??";
+			blunders[side]++;
+		}
+		else if ( delta >= blunder / 2 )
+		{
+			flag = "?";
+			mistakes[side]++;
+		}
+		if ( measured )
+		{
+			loss[side] += delta;
+			counted[side]++;
+		}
+		os << setw( 6 ) << i + 1 << "  " << left << setw( 4 ) << p.move.asString() << right
+		   << setw( 10 ) << score( p.score ) << "  " << left << setw( 4 ) << p.best.asString() << right
+		   << setw( 10 ) << score( p.bestScore ) << setw( 10 ) << ( measured ? to_string( delta ) : "-" )
+		   << ' ' << flag << endl;
+	}
+	for ( int side = 1; side <= 2; side++ )
+		os << ( side == 1 ? "first player:  " : "second player: " ) << blunders[side] << " blunders, "
+		   << mistakes[side] << " mistakes, average loss " << ( counted[side] ? loss[side] / counted[side] : 0 ) << endl;
+	os << endl;
+	return os.str();
+}
+
+// results in the order of the files
+static vector<string> results;
+static vector<bool> finished;
+static mutex resultMutex;
+static condition_variable resultReady;
+
+static void worker( const vector<string>& files_, atomic<size_t>& next_ )
+//-------------------------------------------------------------------------------
+{
+	Engine engine( boardSize );
+	engine.searchTime( searchTime );
+	if ( searchDepth )
+		engine.searchDepth( searchDepth );
+	engine.threads( threads );
+	engine.hashSize( hashSize );
+	size_t i;
+	while ( ( i = next_++ ) < files_.size() )
+	{
+		// (the same sequence for each game, independent of the worker)
+		engine.seed( seed + i );
+		string result = analyseGame( engine, files_[i] );
+		lock_guard<mutex> lock( resultMutex );
+		results[i] = result;
+		finished[i] = true;
+		resultReady.notify_all();
+	}
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	int parallel = thread::hardware_concurrency();
+	if ( parallel < 1 )
+		parallel = 1;
+	vector<string> files;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		string value = i + 1 < argc_ ? argv_[i + 1] : "";
+		if ( arg == "-j" )
+			parallel = atoi( value.c_str() ), i++;
+		else if ( arg == "-time" )
+			searchTime = atof( value.c_str() ), i++;
+		else if ( arg == "-depth" )
+			searchDepth = atoi( value.c_str() ), i++;
+		else if ( arg == "-threads" )
+			threads = atoi( value.c_str() ), i++;
+		else if ( arg == "-hash" )
+			hashSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-size" )
+			boardSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-blunder" )
+			blunder = atoi( value.c_str() ), i++;
+		else if ( arg == "-seed" )
+			seed = strtoull( value.c_str(), 0, 10 ), i++;
+		else if ( arg[0] != '-' )
+			files.push_back( arg );
+		else
+			files.clear(), i = argc_;
+	}
+	if ( files.empty() || parallel < 1 || ( searchTime <= 0 && !searchDepth ) ||
+	     ( boardSize != Engine::BS_Small && boardSize != Engine::BS_Medium && boardSize != Engine::BS_Standard ) )
+	{
+		cerr << "usage: " << argv_[0] << " [-j parallel games] [-time seconds] [-depth plies] [-threads n]" << endl <<
+		     "\t[-hash MB] [-size 11|15|19] [-blunder score] [-seed n] game.gom..." << endl;
+		return EXIT_FAILURE;
+	}
+	// a depth without a time: only the depth bounds the search
+	if ( searchDepth && searchTime <= 0 )
+		searchTime = 1e6;
+
+	double start = now();
+	results.resize( files.size() );
+	finished.resize( files.size() );
+	atomic<size_t> next( 0 );
+	vector<thread> workers;
+	for ( int i = 0; i < parallel && i < (int)files.size(); i++ )
+		workers.emplace_back( worker, cref( files ), ref( next ) );
+	for ( size_t i = 0; i < files.size(); i++ )
+	{
+		unique_lock<mutex> lock( resultMutex );
+		resultReady.wait( lock, [i]{ return finished[i]; } );
+		cout << results[i] << flush;
+		results[i].clear();
+	}
+	for ( size_t i = 0; i < workers.size(); i++ )
+		workers[i].join();
+	double elapsed = now() - start;
+	cerr << files.size() << " games in " << elapsed << " s (" << files.size() / elapsed << " games/sec)" << endl;
+	return EXIT_SUCCESS;
+}
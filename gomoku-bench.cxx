@@ -0,0 +1,495 @@
+/*
+
+ FLTK Gomoku - engine benchmark
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Times Engine::findMove() on board files (e.g. the boards in test/) and reports
+ the time, CPU cycles, heap allocations and search nodes per call. The move
+ found is checked against an annotation "expect: #Xx [#Yy..]" (any of the
+ moves) in the comment below the board. With -json a machine readable summary
+ is written (the exit status is 1 if a check fails only with -strict).
+ With -count the line counting of all empty cells is timed instead, comparing
+ the scalar ::count() with the BitBoard implementation and its pattern table
+ lookup (and checking that all give the same results).
+ With -smp the time to a fixed search depth (-depth) is measured for 1, 2, 4,
+ 8 and 16 search threads over all given boards.
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <new>
+#include <thread>
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#define HAVE_RDTSC
+#endif
+
+using namespace std;
+
+static const int PLAYER = 1;
+static const int COMPUTER = 2;
+
+// count heap allocations of the whole program
+static size_t allocations = 0;
+
+void *operator new( size_t size_ )
+{
+	allocations++;
+	if ( void *p = malloc( size_ ? size_ : 1 ) )
+		return p;
+	throw std::bad_alloc();
+}
+
+void operator delete( void *p_ ) noexcept
+{
+	free( p_ );
+}
+
+void operator delete( void *p_, size_t ) noexcept
+{
+	free( p_ );
+}
+
+static unsigned long long cycles()
+//-------------------------------------------------------------------------------
+{
+#ifdef HAVE_RDTSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+// search settings from the command line
+static double searchTime = 0;
+static int searchDepth = 0;
+static int threads = 1;
+static uint64_t seed = 1; // random numbers of the engine (same for each call)
+
+static bool loadBoard( const string& f_, Engine& engine_, int& who_, vector<string> *expect_ = 0 )
+//-------------------------------------------------------------------------------
+{
+	ifstream ifs( f_.c_str() );
+	if ( !ifs.is_open() )
+	{
+		cerr << f_ << ": can't open" << endl;
+		return false;
+	}
+	int last_moved = 0;
+	Move last_move;
+	engine_.loadBoard( ifs, PLAYER, last_moved, last_move );
+	who_ = last_moved == COMPUTER ? PLAYER : COMPUTER;
+	// expected move(s) from the comment after the board
+	string line;
+	while ( expect_ && getline( ifs, line ) )
+	{
+		if ( line.compare( 0, 7, "expect:" ) )
+			continue;
+		istringstream is( line.substr( 7 ) );
+		string m;
+		while ( is >> m )
+			if ( m[0] == '#' )
+				expect_->push_back( m );
+	}
+	engine_.searchTime( searchTime );
+	if ( searchDepth )
+		engine_.searchDepth( searchDepth );
+	engine_.threads( threads );
+	return true;
+}
+
+// result of one board
+struct Result
+{
+	string file;
+	double us;
+	unsigned long long cycles;
+	double allocs;
+	long nodes;
+	int depth;
+	string move;
+	string expect; // expected moves (empty if none)
+	int passed; // number of iterations with an expected move
+};
+
+static bool benchBoard( const string& f_, int iterations_, Result& r_ )
+//-------------------------------------------------------------------------------
+{
+	Engine engine;
+	int who;
+	vector<string> expect;
+	if ( !loadBoard( f_, engine, who, &expect ) )
+		return false;
+
+	Move move;
+	r_.file = f_;
+	r_.nodes = 0;
+	r_.depth = 0;
+	r_.passed = 0;
+	r_.expect.erase();
+	for ( size_t i = 0; i < expect.size(); i++ )
+		r_.expect += ( i ? " " : "" ) + expect[i];
+	size_t allocs = 0;
+	unsigned long long c = 0;
+	double us = 0;
+	for ( int i = 0; i < iterations_; i++ )
+	{
+		engine.seed( seed ); // each call with the same seed
+		size_t a = allocations;
+		unsigned long long c0 = cycles();
+		auto start = chrono::steady_clock::now();
+		engine.findMove( move, who );
+		us += chrono::duration<double, micro>( chrono::steady_clock::now() - start ).count();
+		c += cycles() - c0;
+		allocs += allocations - a;
+		r_.nodes += engine.nodes();
+		if ( engine.depth() > r_.depth )
+			r_.depth = engine.depth();
+		for ( size_t j = 0; j < expect.size(); j++ )
+			r_.passed += expect[j] == move.asString();
+	}
+	r_.us = us / iterations_;
+	r_.cycles = c / iterations_;
+	r_.allocs = (double)allocs / iterations_;
+	r_.nodes /= iterations_;
+	r_.move = move.asString();
+
+	cout << left << setw( 40 ) << f_ << right
+	     << fixed << setprecision( 2 ) << setw( 12 ) << r_.us << " us"
+	     << setw( 12 ) << r_.cycles << " cycles"
+	     << setw( 6 ) << setprecision( 1 ) << r_.allocs << " allocs"
+	     << setw( 9 ) << r_.nodes << " nodes"
+	     << setw( 3 ) << r_.depth << " depth"
+	     << "  " << r_.move;
+	if ( expect.size() )
+		cout << ( r_.passed == iterations_ ? "  ok" : "  FAIL (expected " + r_.expect + ")" );
+	cout << endl;
+	return true;
+}
+
+static bool writeJson( const string& f_, const vector<Result>& results_, int iterations_ )
+//-------------------------------------------------------------------------------
+{
+	ofstream os( f_.c_str() );
+	if ( !os.is_open() )
+	{
+		cerr << f_ << ": can't write" << endl;
+		return false;
+	}
+	int checked = 0;
+	int passed = 0;
+	double us = 0;
+	long nodes = 0;
+	os << "{" << endl;
+	os << "  \"search_time\": " << searchTime << "," << endl;
+	os << "  \"search_depth\": " << searchDepth << "," << endl;
+	os << "  \"threads\": " << threads << "," << endl;
+	os << "  \"seed\": " << seed << "," << endl;
+	os << "  \"iterations\": " << iterations_ << "," << endl;
+	os << "  \"positions\": [" << endl;
+	for ( size_t i = 0; i < results_.size(); i++ )
+	{
+		const Result& r = results_[i];
+		bool check = r.expect.size();
+		checked += check;
+		passed += check && r.passed == iterations_;
+		us += r.us;
+		nodes += r.nodes;
+		os << "    { \"file\": \"" << r.file << "\", \"us\": " << fixed << setprecision( 2 ) << r.us
+		   << ", \"cycles\": " << r.cycles << ", \"allocs\": " << setprecision( 1 ) << r.allocs
+		   << ", \"nodes\": " << r.nodes << ", \"depth\": " << r.depth
+		   << ", \"move\": \"" << r.move << "\", \"expect\": \"" << r.expect << "\""
+		   << ", \"result\": \"" << ( !check ? "none" : r.passed == iterations_ ? "ok" : "fail" ) << "\" }"
+		   << ( i + 1 < results_.size() ? "," : "" ) << endl;
+	}
+	os << "  ]," << endl;
+	os << "  \"summary\": { \"positions\": " << results_.size() << ", \"checked\": " << checked
+	   << ", \"passed\": " << passed << ", \"failed\": " << checked - passed
+	   << ", \"total_us\": " << setprecision( 2 ) << us << ", \"total_nodes\": " << nodes << " }" << endl;
+	os << "}" << endl;
+	return true;
+}
+
+// keeps the counting results from being optimized away
+static volatile int sink = 0;
+
+static bool samePattern( const PosInfo& a_, const PosInfo& b_ )
+//-------------------------------------------------------------------------------
+{
+	// the pattern table limits freedoms to its window and overlines to its
+	// length, so compare what the evaluation uses
+	return ( a_.n == b_.n || ( a_.n > 5 && b_.n > 5 ) ) && a_.gap == b_.gap &&
+	       a_.canWin() == b_.canWin() && a_.single_freedom() == b_.single_freedom();
+}
+
+static bool benchCount( const string& f_, int iterations_ )
+//-------------------------------------------------------------------------------
+{
+	Engine engine;
+	int who;
+	if ( !loadBoard( f_, engine, who ) )
+		return false;
+	Board board;
+	memcpy( board, engine.board(), sizeof( board ) );
+	BitBoard bits( engine.size() );
+	for ( int x = 1; x <= engine.size(); x++ )
+		for ( int y = 1; y <= engine.size(); y++ )
+			if ( board[x][y] > 0 )
+				bits.set( x, y, board[x][y] );
+
+	static const int DIR[4 + 1][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { -1, -1 }, { 1, -1 } };
+	long cells = 0;
+	int mismatches = 0;
+	int check = 0;
+	auto start = chrono::steady_clock::now();
+	unsigned long long c = cycles();
+	for ( int i = 0; i < iterations_; i++ )
+		for ( int x = 1; x <= engine.size(); x++ )
+			for ( int y = 1; y <= engine.size(); y++ )
+			{
+				if ( board[x][y] )
+					continue;
+				for ( int who = 1; who <= 2; who++ )
+				{
+					Eval e;
+					board[x][y] = who;
+					for ( int dir = 1; dir <= 4; dir++ )
+						::count( x, y, DIR[dir][0], DIR[dir][1], e.info[dir], board );
+					board[x][y] = 0;
+					check += e.info[1].n + e.info[4].n;
+					cells++;
+				}
+			}
+	unsigned long long cScalar = cycles() - c;
+	double usScalar = chrono::duration<double, micro>( chrono::steady_clock::now() - start ).count();
+
+	start = chrono::steady_clock::now();
+	c = cycles();
+	for ( int i = 0; i < iterations_; i++ )
+		for ( int x = 1; x <= engine.size(); x++ )
+			for ( int y = 1; y <= engine.size(); y++ )
+			{
+				if ( board[x][y] )
+					continue;
+				for ( int who = 1; who <= 2; who++ )
+				{
+					Eval e;
+					bits.countPos( x, y, who, e );
+					check -= e.info[1].n + e.info[4].n;
+				}
+			}
+	unsigned long long cBits = cycles() - c;
+	double usBits = chrono::duration<double, micro>( chrono::steady_clock::now() - start ).count();
+
+	start = chrono::steady_clock::now();
+	c = cycles();
+	for ( int i = 0; i < iterations_; i++ )
+		for ( int x = 1; x <= engine.size(); x++ )
+			for ( int y = 1; y <= engine.size(); y++ )
+			{
+				if ( board[x][y] )
+					continue;
+				for ( int who = 1; who <= 2; who++ )
+				{
+					Eval e;
+					bits.lookupPos( x, y, who, e );
+					check += e.info[2].n + e.info[3].n;
+				}
+			}
+	unsigned long long cTable = cycles() - c;
+	double usTable = chrono::duration<double, micro>( chrono::steady_clock::now() - start ).count();
+
+	// compare the results (outside of the timing)
+	for ( int x = 1; x <= engine.size(); x++ )
+		for ( int y = 1; y <= engine.size(); y++ )
+		{
+			if ( board[x][y] )
+				continue;
+			for ( int who = 1; who <= 2; who++ )
+			{
+				Eval e1, e2, e3;
+				board[x][y] = who;
+				for ( int dir = 1; dir <= 4; dir++ )
+					::count( x, y, DIR[dir][0], DIR[dir][1], e1.info[dir], board );
+				board[x][y] = 0;
+				bits.countPos( x, y, who, e2 );
+				bits.lookupPos( x, y, who, e3 );
+				if ( memcmp( e1.info, e2.info, sizeof( e1.info ) ) )
+					mismatches++;
+				for ( int dir = 1; dir <= 4; dir++ )
+					if ( !samePattern( e1.info[dir], e3.info[dir] ) )
+						mismatches++;
+			}
+		}
+
+	double n = cells ? cells : 1;
+	cout << left << setw( 40 ) << f_ << right
+	     << fixed << setprecision( 1 )
+	     << " scalar" << setw( 8 ) << usScalar * 1000 / n << " ns" << setw( 6 ) << cScalar / n << " cyc"
+	     << "   bitboard" << setw( 8 ) << usBits * 1000 / n << " ns" << setw( 6 ) << cBits / n << " cyc"
+	     << "   table" << setw( 8 ) << usTable * 1000 / n << " ns" << setw( 6 ) << cTable / n << " cyc";
+	if ( mismatches )
+		cout << "  " << mismatches << " MISMATCHES";
+	cout << endl;
+	sink = check;
+	return mismatches == 0;
+}
+
+static bool benchSmp( const vector<string>& files_, int iterations_ )
+//-------------------------------------------------------------------------------
+{
+	// time to the fixed search depth (without time limit) per thread count,
+	// summed over all boards (each search starts with an empty hash table)
+	static const int THREADS[] = { 1, 2, 4, 8, 16 };
+	double base = 0;
+	for ( int t : THREADS )
+	{
+		double us = 0;
+		long nodes = 0;
+		for ( const string& f : files_ )
+		{
+			Engine engine;
+			int who;
+			if ( !loadBoard( f, engine, who ) )
+				return false;
+			engine.searchTime( 1e6 );
+			engine.vctDepth( 0 ); // (single threaded, would dominate the time)
+			engine.threads( t );
+			for ( int i = 0; i < iterations_; i++ )
+			{
+				engine.hashSize( 16 );
+				Move move;
+				engine.seed( seed );
+				auto start = chrono::steady_clock::now();
+				engine.findMove( move, who );
+				us += chrono::duration<double, micro>( chrono::steady_clock::now() - start ).count();
+				nodes += engine.nodes();
+			}
+		}
+		if ( t == 1 )
+			base = us;
+		cout << setw( 3 ) << t << " threads" << fixed << setprecision( 1 )
+		     << setw( 12 ) << us / 1000 / iterations_ << " ms"
+		     << setw( 12 ) << nodes / iterations_ << " nodes"
+		     << setw( 10 ) << (long)( nodes / ( us > 0 ? us : 1 ) * 1e6 ) << " nps"
+		     << setprecision( 2 ) << setw( 8 ) << base / ( us > 0 ? us : 1 ) << "x" << endl;
+	}
+	return true;
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	int iterations = 10;
+	bool count = false;
+	bool smp = false;
+	bool strict = false;
+	string json;
+	vector<string> files;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		if ( arg == "-n" )
+		{
+			if ( ++i < argc_ )
+				iterations = atoi( argv_[i] );
+		}
+		else if ( arg == "-count" )
+			count = true;
+		else if ( arg == "-smp" )
+			smp = true;
+		else if ( arg == "-strict" )
+			strict = true;
+		else if ( arg == "-json" )
+		{
+			if ( ++i < argc_ )
+				json = argv_[i];
+		}
+		else if ( arg == "-time" )
+		{
+			if ( ++i < argc_ )
+				searchTime = atof( argv_[i] );
+		}
+		else if ( arg == "-depth" )
+		{
+			if ( ++i < argc_ )
+				searchDepth = atoi( argv_[i] );
+		}
+		else if ( arg == "-threads" )
+		{
+			if ( ++i < argc_ )
+				threads = atoi( argv_[i] );
+		}
+		else if ( arg == "-seed" )
+		{
+			if ( ++i < argc_ )
+				seed = strtoull( argv_[i], 0, 10 );
+		}
+		else
+			files.push_back( arg );
+	}
+	if ( files.empty() || iterations <= 0 )
+	{
+		cerr << "usage: " << argv_[0] << " [-n iterations] [-time seconds] [-depth plies] [-threads n]" << endl <<
+		     "\t[-seed n] [-json summary.json] [-strict] [-count | -smp] board.txt..." << endl;
+		return EXIT_FAILURE;
+	}
+	if ( smp )
+	{
+		if ( !searchDepth )
+			searchDepth = 6;
+		cout << "search to depth " << searchDepth << " on " << files.size() << " boards ("
+		     << iterations << " iterations, " << thread::hardware_concurrency() << " cores)" << endl;
+		return benchSmp( files, iterations ) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+	if ( count )
+	{
+		cout << "pattern table: " << BitBoard::tableSize() / 1024 << " KB, built in "
+		     << fixed << setprecision( 2 ) << BitBoard::tableTime() * 1000 << " ms" << endl;
+		cout << "line counting per empty cell and colour (" << iterations << " iterations)" << endl;
+	}
+	else
+		cout << "findMove() per call (" << iterations << " iterations, search time " << searchTime << " s)" << endl;
+	int failed = 0;
+	vector<Result> results;
+	for ( size_t i = 0; i < files.size(); i++ )
+	{
+		if ( count )
+		{
+			failed += !benchCount( files[i], iterations );
+			continue;
+		}
+		Result r;
+		if ( !benchBoard( files[i], iterations, r ) )
+		{
+			failed++;
+			continue;
+		}
+		results.push_back( r );
+		if ( strict && r.expect.size() && r.passed != iterations )
+			failed++;
+	}
+	if ( json.size() && !writeJson( json, results, iterations ) )
+		failed++;
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+/*
+
+ FLTK Gomoku - opening book builder
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Builds the opening book (see book.h) from games in the format of the
+ GUI's "Save game.." (e.g. written by gomoku-selfplay -o): the moves of
+ the first plies of each game are counted with the result of the game
+ for the colour making them. Shows the contents of a book with -info.
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include "book.h"
+#include <vector>
+#include <map>
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <ctime>
+
+using namespace std;
+
+static int plies = 10;
+static int minGames = 2;
+static int boardSize = Engine::BS_Standard;
+
+struct Stats
+{
+	int games = 0;
+	int wins = 0;
+	int draws = 0;
+};
+
+// (key, canonical move x << 5 | y)
+typedef map<pair<uint64_t, int>, Stats> BookMap;
+
+static bool readGame( const string& f_, vector<Move>& moves_ )
+//-------------------------------------------------------------------------------
+{
+	// moves of both colours alternating ('-' if the other colour began)
+	ifstream ifs( f_.c_str() );
+	if ( !ifs.is_open() )
+		return false;
+	moves_.clear();
+	string m;
+	while ( ifs >> m )
+	{
+		if ( m[0] == '#' )
+		{
+			Move move( m );
+			if ( !move.valid() || move.x > boardSize || move.y > boardSize )
+				return false;
+			moves_.push_back( move );
+		}
+		else if ( m != "-" || moves_.size() )
+			return false;
+	}
+	return moves_.size() > 0;
+}
+
+static bool addGame( const vector<Move>& moves_, BookMap& book_ )
+//-------------------------------------------------------------------------------
+{
+	// replay the game for its result, then count its first plies
+	Engine engine( boardSize );
+	int who = 1;
+	int winner = 0;
+	for ( size_t i = 0; i < moves_.size() && !winner; i++, who = 3 - who )
+	{
+		if ( engine.at( moves_[i].x, moves_[i].y ) )
+			return false;
+		engine.setPiece( moves_[i].x, moves_[i].y, who );
+		if ( engine.checkWin( moves_[i].x, moves_[i].y ) )
+			winner = who;
+	}
+	engine.clearBoard();
+	who = 1;
+	for ( int i = 0; i < plies && i < (int)moves_.size(); i++, who = 3 - who )
+	{
+		int sym;
+		uint64_t key = engine.canonicalKey( who, sym );
+		int x = moves_[i].x;
+		int y = moves_[i].y;
+		engine.symmetry( sym, x, y );
+		Stats& s = book_[make_pair( key, x << 5 | y )];
+		s.games++;
+		s.wins += winner == who;
+		s.draws += winner == 0;
+		engine.setPiece( moves_[i].x, moves_[i].y, who );
+	}
+	return true;
+}
+
+static int info( const string& f_ )
+//-------------------------------------------------------------------------------
+{
+	Book book;
+	if ( !book.load( f_ ) )
+	{
+		cerr << f_ << ": no book" << endl;
+		return EXIT_FAILURE;
+	}
+	cout << f_ << ": " << book.entries() << " entries, board size " << book.size()
+	     << ", positions with less than " << book.plies() << " pieces" << endl;
+	// a book move for the empty board
+	Engine engine( book.size() );
+	Random rng( time( 0 ) );
+	Move move;
+	if ( book.probe( engine, 1, move, rng ) )
+		cout << "first move (e.g.): " << move.asString() << endl;
+	return EXIT_SUCCESS;
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	string out;
+	vector<string> files;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		string value = i + 1 < argc_ ? argv_[i + 1] : "";
+		if ( arg == "-o" )
+			out = value, i++;
+		else if ( arg == "-plies" )
+			plies = atoi( value.c_str() ), i++;
+		else if ( arg == "-min" )
+			minGames = atoi( value.c_str() ), i++;
+		else if ( arg == "-size" )
+			boardSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-info" )
+			return info( value );
+		else
+			files.push_back( arg );
+	}
+	if ( out.empty() || files.empty() || plies <= 0 ||
+	     ( boardSize != Engine::BS_Small && boardSize != Engine::BS_Medium && boardSize != Engine::BS_Standard ) )
+	{
+		cerr << "usage: " << argv_[0] << " -o book.bin [-plies n] [-min games] [-size 11|15|19] game.gom..." << endl <<
+		     "       " << argv_[0] << " -info book.bin" << endl;
+		return EXIT_FAILURE;
+	}
+
+	BookMap book;
+	int games = 0;
+	vector<Move> moves;
+	for ( size_t i = 0; i < files.size(); i++ )
+	{
+		if ( readGame( files[i], moves ) && addGame( moves, book ) )
+			games++;
+		else
+			cerr << files[i] << ": no valid game, skipped" << endl;
+	}
+
+	vector<Book::Entry> entries;
+	for ( BookMap::const_iterator it = book.begin(); it != book.end(); ++it )
+	{
+		const Stats& s = it->second;
+		if ( s.games < minGames )
+			continue;
+		Book::Entry e;
+		e.key = it->first.first;
+		e.x = it->first.second >> 5;
+		e.y = it->first.second & 31;
+		// (counts are kept in 16 bits, scaled down if needed)
+		int div = s.games / 65536 + 1;
+		e.games = s.games / div;
+		e.wins = s.wins / div;
+		e.draws = s.draws / div;
+		entries.push_back( e );
+	}
+	if ( !Book::write( out, entries, boardSize, plies ) )
+	{
+		cerr << out << ": can't write" << endl;
+		return EXIT_FAILURE;
+	}
+	cout << games << " games, " << book.size() << " moves, " << entries.size()
+	     << " with at least " << minGames << " games written to " << out << endl;
+	return EXIT_SUCCESS;
+}
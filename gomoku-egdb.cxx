@@ -0,0 +1,398 @@
+/*
+
+ FLTK Gomoku - endgame database builder
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Builds the endgame database (see egdb.h) from games in the format of the
+ GUI's "Save game.." (e.g. written by gomoku-selfplay -size 11 -o): every
+ position of the games is searched for a forced win with a deep threat
+ search, positions with few empty cells (and all positions reached from
+ them) are solved exactly. Checks a database against the games with
+ -verify: exact results are solved again, the stored move of a threat
+ win is replayed (the node limited threat search depends on the order of
+ the candidates, so it may not find the same win again).
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include "egdb.h"
+#include <vector>
+#include <unordered_map>
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+
+static int boardSize = Engine::BS_Small;
+static int maxEmpty = 12;
+static int vctDepth = 9;
+static long threatLimit = 20000;
+static int minPieces = 6;
+
+static double now()
+//-------------------------------------------------------------------------------
+{
+	return chrono::duration<double>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static bool readGame( const string& f_, vector<Move>& moves_ )
+//-------------------------------------------------------------------------------
+{
+	// moves of both colours alternating ('-' if the other colour began)
+	ifstream ifs( f_.c_str() );
+	if ( !ifs.is_open() )
+		return false;
+	moves_.clear();
+	string m;
+	while ( ifs >> m )
+	{
+		if ( m[0] == '#' )
+		{
+			Move move( m );
+			if ( !move.valid() || move.x > boardSize || move.y > boardSize )
+				return false;
+			moves_.push_back( move );
+		}
+		else if ( m != "-" || moves_.size() )
+			return false;
+	}
+	return moves_.size() > 0;
+}
+
+//-------------------------------------------------------------------------------
+class Exact
+//-------------------------------------------------------------------------------
+{
+	// Exact result of a position by a full search over all empty cells,
+	// memoised by the canonical key (so every position is solved once).
+public:
+	Exact( Engine& engine_ ) : _engine( engine_ ) {}
+	// 1 = win, 0 = draw, -1 = loss for who_
+	int solve( int who_ );
+	// all solved positions except immediate wins
+	void entries( vector<uint64_t>& entries_ ) const;
+	size_t positions() const { return _memo.size(); }
+private:
+	struct Result
+	{
+		signed char value;
+		bool trivial; // (immediate win)
+		unsigned char x; // canonical move
+		unsigned char y;
+	};
+	int negamax( int who_ );
+	int store( uint64_t key_, int sym_, int value_, int x_, int y_, bool trivial_ = false );
+	bool wins( int x_, int y_, int who_ );
+private:
+	Engine& _engine;
+	Board _board; // (for testing cells without updating the engine)
+	unordered_map<uint64_t, Result> _memo;
+};
+
+bool Exact::wins( int x_, int y_, int who_ )
+//-------------------------------------------------------------------------------
+{
+	Eval e;
+	_board[x_][y_] = who_;
+	_engine.countPos( x_, y_, e, _board );
+	_board[x_][y_] = 0;
+	return e.wins();
+}
+
+int Exact::store( uint64_t key_, int sym_, int value_, int x_, int y_, bool trivial_/* = false*/ )
+//-------------------------------------------------------------------------------
+{
+	_engine.symmetry( sym_, x_, y_ );
+	Result& r = _memo[key_];
+	r.value = value_;
+	r.trivial = trivial_;
+	r.x = x_;
+	r.y = y_;
+	return value_;
+}
+
+int Exact::solve( int who_ )
+//-------------------------------------------------------------------------------
+{
+	memcpy( _board, _engine.board(), sizeof( _board ) );
+	return negamax( who_ );
+}
+
+int Exact::negamax( int who_ )
+//-------------------------------------------------------------------------------
+{
+	int sym;
+	uint64_t key = _engine.canonicalKey( who_, sym );
+	auto it = _memo.find( key );
+	if ( it != _memo.end() )
+		return it->second.value;
+	int BS = _engine.size();
+	vector<Move> moves;
+	int threats = 0;
+	for ( int x = 1; x <= BS; x++ )
+	{
+		for ( int y = 1; y <= BS; y++ )
+		{
+			if ( _engine.at( x, y ) )
+				continue;
+			if ( wins( x, y, who_ ) )
+				return store( key, sym, 1, x, y, true );
+			if ( wins( x, y, 3 - who_ ) )
+			{
+				// (the opponent's five must be blocked)
+				if ( !threats++ )
+					moves.clear();
+				moves.push_back( Move( x, y ) );
+			}
+			else if ( !threats )
+				moves.push_back( Move( x, y ) );
+		}
+	}
+	if ( moves.empty() )
+		return 0; // (full board)
+	if ( threats > 1 )
+		return store( key, sym, -1, moves[0].x, moves[0].y );
+	int best = -2;
+	Move bestMove;
+	for ( size_t i = 0; i < moves.size() && best < 1; i++ )
+	{
+		_engine.setPiece( moves[i].x, moves[i].y, who_ );
+		_board[moves[i].x][moves[i].y] = who_;
+		int value = _engine.full() ? 0 : -negamax( 3 - who_ );
+		_board[moves[i].x][moves[i].y] = 0;
+		_engine.removePiece( moves[i].x, moves[i].y );
+		if ( value > best )
+		{
+			best = value;
+			bestMove = moves[i];
+		}
+	}
+	return store( key, sym, best, bestMove.x, bestMove.y );
+}
+
+void Exact::entries( vector<uint64_t>& entries_ ) const
+//-------------------------------------------------------------------------------
+{
+	static const EndgameDB::Result results[3] = { EndgameDB::R_Loss, EndgameDB::R_Draw, EndgameDB::R_Win };
+	for ( auto it = _memo.begin(); it != _memo.end(); ++it )
+	{
+		const Result& r = it->second;
+		if ( !r.trivial )
+			entries_.push_back( EndgameDB::entry( it->first, results[r.value + 1], r.x, r.y ) );
+	}
+}
+
+static void setup( Engine& engine_ )
+//-------------------------------------------------------------------------------
+{
+	engine_.vcfDepth( vctDepth * 2 );
+	engine_.vctDepth( vctDepth );
+	engine_.threatLimit( threatLimit );
+}
+
+// forced win of who_ by the threat search (not an immediate five)
+static bool threatWin( Engine& engine_, int who_, Move& move_ )
+//-------------------------------------------------------------------------------
+{
+	if ( engine_.pieces() < minPieces || !engine_.solve( move_, who_ ) )
+		return false;
+	engine_.setPiece( move_.x, move_.y, who_ );
+	bool five = engine_.checkWin( move_.x, move_.y );
+	engine_.removePiece( move_.x, move_.y );
+	return !five;
+}
+
+// the stored move of a threat win replayed: 1 if the threat search finds
+// a win again, -1 if the opponent wins after the move, else 0 (not found
+// within the node limit)
+static int replayWin( Engine& engine_, int who_, const Move& move_ )
+//-------------------------------------------------------------------------------
+{
+	Move move;
+	if ( threatWin( engine_, who_, move ) )
+		return 1;
+	engine_.setPiece( move_.x, move_.y, who_ );
+	int value = engine_.checkWin( move_.x, move_.y ) ? 1 : engine_.solve( move, 3 - who_ ) ? -1 : 0;
+	engine_.removePiece( move_.x, move_.y );
+	return value;
+}
+
+static int verify( const string& db_, const vector<string>& files_ )
+//-------------------------------------------------------------------------------
+{
+	// structure of the file, then the results of all positions of the
+	// games found in it solved again (threat wins replayed)
+	EndgameDB db;
+	if ( !db.load( db_ ) )
+	{
+		cerr << db_ << ": no endgame database" << endl;
+		return EXIT_FAILURE;
+	}
+	string error;
+	if ( !db.check( error ) )
+	{
+		cerr << db_ << ": " << error << endl;
+		return EXIT_FAILURE;
+	}
+	cout << db_ << ": " << db.entries() << " entries, board size " << db.size()
+	     << ", exact with up to " << db.empty() << " empty cells" << endl;
+	boardSize = db.size();
+	Engine engine( boardSize );
+	setup( engine );
+	Exact exact( engine );
+	long found = 0;
+	long wrong = 0;
+	long unconfirmed = 0;
+	vector<Move> moves;
+	for ( size_t i = 0; i < files_.size(); i++ )
+	{
+		if ( !readGame( files_[i], moves ) )
+			continue;
+		engine.clearBoard();
+		int who = 1;
+		for ( size_t j = 0; j < moves.size(); j++, who = 3 - who )
+		{
+			if ( engine.at( moves[j].x, moves[j].y ) )
+				break;
+			Move move;
+			EndgameDB::Result result = db.probe( engine, who, move );
+			if ( result != EndgameDB::R_Unknown )
+			{
+				found++;
+				EndgameDB::Result expected = EndgameDB::R_Unknown;
+				if ( engine.size() * engine.size() - engine.pieces() <= db.empty() )
+				{
+					int value = exact.solve( who );
+					expected = value > 0 ? EndgameDB::R_Win : value < 0 ? EndgameDB::R_Loss : EndgameDB::R_Draw;
+				}
+				else if ( result == EndgameDB::R_Win )
+				{
+					int value = replayWin( engine, who, move );
+					expected = value < 0 ? EndgameDB::R_Loss : EndgameDB::R_Win;
+					unconfirmed += value == 0;
+				}
+				if ( result != expected )
+				{
+					wrong++;
+					cerr << files_[i] << ": ply " << j << ": result " << result
+					     << ", solved " << expected << endl;
+				}
+			}
+			engine.setPiece( moves[j].x, moves[j].y, who );
+			if ( engine.checkWin( moves[j].x, moves[j].y ) )
+				break;
+		}
+	}
+	cout << found << " positions of the games found, " << wrong << " wrong, "
+	     << unconfirmed << " threat wins not found again" << endl;
+	return wrong ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	string out;
+	string verifyFile;
+	vector<string> files;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		string value = i + 1 < argc_ ? argv_[i + 1] : "";
+		if ( arg == "-o" )
+			out = value, i++;
+		else if ( arg == "-empty" )
+			maxEmpty = atoi( value.c_str() ), i++;
+		else if ( arg == "-vct" )
+			vctDepth = atoi( value.c_str() ), i++;
+		else if ( arg == "-limit" )
+			threatLimit = atol( value.c_str() ), i++;
+		else if ( arg == "-min" )
+			minPieces = atoi( value.c_str() ), i++;
+		else if ( arg == "-size" )
+			boardSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-verify" )
+			verifyFile = value, i++;
+		else
+			files.push_back( arg );
+	}
+	if ( verifyFile.size() )
+		return verify( verifyFile, files );
+	if ( out.empty() || files.empty() || maxEmpty < 0 || maxEmpty > 16 ||
+	     ( boardSize != Engine::BS_Small && boardSize != Engine::BS_Medium && boardSize != Engine::BS_Standard ) )
+	{
+		cerr << "usage: " << argv_[0] << " -o egdb.bin [-empty cells] [-vct depth] [-limit nodes]" << endl <<
+		     "\t[-min pieces] [-size 11|15|19] game.gom..." << endl <<
+		     "       " << argv_[0] << " -verify egdb.bin [game.gom...]" << endl;
+		return EXIT_FAILURE;
+	}
+
+	double start = now();
+	Engine engine( boardSize );
+	setup( engine );
+	Exact exact( engine );
+	vector<uint64_t> entries;
+	int games = 0;
+	long positions = 0;
+	long wins = 0;
+	vector<Move> moves;
+	for ( size_t i = 0; i < files.size(); i++ )
+	{
+		if ( !readGame( files[i], moves ) )
+		{
+			cerr << files[i] << ": no valid game, skipped" << endl;
+			continue;
+		}
+		games++;
+		double gameStart = now();
+		long gameWins = wins;
+		engine.clearBoard();
+		int who = 1;
+		for ( size_t j = 0; j < moves.size(); j++, who = 3 - who )
+		{
+			if ( engine.at( moves[j].x, moves[j].y ) )
+				break;
+			positions++;
+			Move move;
+			if ( engine.size() * engine.size() - engine.pieces() <= maxEmpty )
+				exact.solve( who );
+			else if ( threatWin( engine, who, move ) )
+			{
+				int sym;
+				uint64_t key = engine.canonicalKey( who, sym );
+				engine.symmetry( sym, move.x, move.y );
+				entries.push_back( EndgameDB::entry( key, EndgameDB::R_Win, move.x, move.y ) );
+				wins++;
+			}
+			engine.setPiece( moves[j].x, moves[j].y, who );
+			if ( engine.checkWin( moves[j].x, moves[j].y ) )
+				break;
+		}
+		// (progress, a game can take seconds)
+		cout << files[i] << ": " << wins - gameWins << " threat wins in " << now() - gameStart << "s" << endl;
+	}
+	exact.entries( entries );
+	if ( !EndgameDB::write( out, entries, boardSize, maxEmpty ) )
+	{
+		cerr << out << ": can't write" << endl;
+		return EXIT_FAILURE;
+	}
+	cout << games << " games, " << positions << " positions (" << wins << " threat wins, "
+	     << exact.positions() << " solved exactly), " << entries.size() << " entries written to "
+	     << out << " in " << now() - start << "s" << endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,326 @@
+/*
+
+ FLTK Gomoku - binary game file converter
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Converts games in the format of the GUI's "Save game.." and boards in
+ the format of "Save board.." (as in test/) into a binary game file (see
+ gamefile.h) and back:
+
+   gomoku-games -o games.gmk [-size n] [-noindex] game.gom|board.txt...
+   gomoku-games -x prefix games.gmk   (prefix-000001.gom, .txt for boards)
+   gomoku-games -cat games.gmk        (all records to stdout)
+   gomoku-games -info games.gmk       (counts and read speed)
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include "gamefile.h"
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+
+using namespace std;
+
+static int boardSize = Engine::BS_Standard;
+
+static double now()
+//-------------------------------------------------------------------------------
+{
+	return chrono::duration<double>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static bool readGame( istream& is_, GameRecord& record_, Engine& engine_ )
+//-------------------------------------------------------------------------------
+{
+	// moves of both colours alternating ('-' if the other colour began),
+	// the winner from replaying them
+	record_ = GameRecord();
+	engine_.clearBoard();
+	int who = 1;
+	string m;
+	while ( is_ >> m )
+	{
+		if ( m[0] == '#' )
+		{
+			Move move( m );
+			if ( !move.valid() || move.x > boardSize || move.y > boardSize ||
+			     engine_.at( move.x, move.y ) || record_.result )
+				return false;
+			engine_.makeMove( move, who );
+			record_.moves.push_back( move );
+			if ( engine_.checkWin( move.x, move.y ) )
+				record_.result = who;
+			who = 3 - who;
+		}
+		else if ( m == "-" && record_.moves.empty() )
+		{
+			record_.otherBegan = true;
+			who = 2;
+		}
+		else
+			return false;
+	}
+	if ( !record_.result && engine_.full() )
+		record_.result = 3;
+	return record_.moves.size() > 0;
+}
+
+static bool readBoard( istream& is_, GameRecord& record_, Engine& engine_ )
+//-------------------------------------------------------------------------------
+{
+	// pieces 'p' colour 1, 'c' colour 2, the colour not moved last to move
+	record_ = GameRecord();
+	record_.type = GameRecord::GR_Position;
+	engine_.clearBoard();
+	int lastMoved = 0;
+	Move lastMove;
+	if ( !engine_.loadBoard( is_, 1, lastMoved, lastMove ) )
+		return false;
+	record_.result = lastMoved == 2 ? 1 : 2;
+	for ( int who = 1; who <= 2; who++ )
+	{
+		if ( who == 2 )
+			record_.first = record_.moves.size();
+		for ( int y = 1; y <= boardSize; y++ )
+			for ( int x = 1; x <= boardSize; x++ )
+				if ( engine_.at( x, y ) == who && ( x != lastMove.x || y != lastMove.y ) )
+					record_.moves.push_back( Move( x, y ) );
+		// (the last move last of its colour)
+		if ( who == lastMoved )
+		{
+			record_.moves.push_back( lastMove );
+			record_.lastMove = true;
+		}
+	}
+	return true;
+}
+
+static bool readText( const string& f_, GameRecord& record_, Engine& engine_ )
+//-------------------------------------------------------------------------------
+{
+	ifstream ifs( f_.c_str() );
+	if ( !ifs.is_open() )
+		return false;
+	// (a board starts with the line of column labels)
+	string line;
+	getline( ifs, line );
+	bool board = line.size() > 2 && line[0] == ' ' && line.find( " a" ) != string::npos;
+	ifs.seekg( 0 );
+	return board ? readBoard( ifs, record_, engine_ ) : readGame( ifs, record_, engine_ );
+}
+
+static ostream& writeText( ostream& os_, const GameRecord& record_, Engine& engine_ )
+//-------------------------------------------------------------------------------
+{
+	engine_.clearBoard();
+	if ( record_.type == GameRecord::GR_Position )
+	{
+		for ( size_t i = 0; i < record_.moves.size(); i++ )
+			engine_.makeMove( record_.moves[i], (int)i < record_.first ? 1 : 2 );
+		// (the last move is the last piece of the colour not to move)
+		Move lastMove;
+		size_t last = record_.result == 1 ? record_.moves.size() : record_.first;
+		if ( record_.lastMove && last )
+			lastMove = record_.moves[last - 1];
+		return engine_.dumpBoard( os_, lastMove, 1 );
+	}
+	int who = record_.otherBegan ? 2 : 1;
+	for ( size_t i = 0; i < record_.moves.size(); i++, who = 3 - who )
+		engine_.makeMove( record_.moves[i], who );
+	return engine_.dumpGame( os_, record_.moves, 1 );
+}
+
+static bool validRecord( const GameRecord& record_ )
+//-------------------------------------------------------------------------------
+{
+	// (no cell twice)
+	vector<bool> used( boardSize * boardSize );
+	for ( size_t i = 0; i < record_.moves.size(); i++ )
+	{
+		int cell = ( record_.moves[i].y - 1 ) * boardSize + record_.moves[i].x - 1;
+		if ( used[cell] )
+			return false;
+		used[cell] = true;
+	}
+	return true;
+}
+
+static int convert( const string& out_, const vector<string>& files_, bool index_ )
+//-------------------------------------------------------------------------------
+{
+	Engine engine( boardSize );
+	GameWriter writer;
+	if ( !writer.open( out_, boardSize, index_ ) )
+	{
+		cerr << out_ << ": can't write" << endl;
+		return EXIT_FAILURE;
+	}
+	GameRecord record;
+	size_t skipped = 0;
+	for ( size_t i = 0; i < files_.size(); i++ )
+	{
+		if ( !readText( files_[i], record, engine ) )
+		{
+			cerr << files_[i] << ": no valid game or board" << endl;
+			skipped++;
+			continue;
+		}
+		if ( !writer.write( record ) )
+		{
+			cerr << out_ << ": write error" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+	size_t count = writer.count();
+	if ( !writer.close() )
+	{
+		cerr << out_ << ": write error" << endl;
+		return EXIT_FAILURE;
+	}
+	cout << out_ << ": " << count << " records (" << skipped << " skipped)" << endl;
+	return EXIT_SUCCESS;
+}
+
+static int extract( const string& in_, const string& prefix_ )
+//-------------------------------------------------------------------------------
+{
+	// prefix_ empty: all records to stdout
+	GameFile file;
+	if ( !file.open( in_ ) )
+	{
+		cerr << in_ << ": no game file" << endl;
+		return EXIT_FAILURE;
+	}
+	boardSize = file.size();
+	Engine engine( boardSize );
+	GameRecord record;
+	size_t offset = file.first();
+	int n = 0;
+	while ( file.read( offset, record ) )
+	{
+		n++;
+		if ( !validRecord( record ) )
+		{
+			cerr << in_ << ": record " << n << " invalid" << endl;
+			return EXIT_FAILURE;
+		}
+		if ( prefix_.empty() )
+		{
+			writeText( cout, record, engine );
+			cout << endl;
+			continue;
+		}
+		ostringstream f;
+		f << prefix_ << "-" << setw( 6 ) << setfill( '0' ) << n <<
+		     ( record.type == GameRecord::GR_Position ? ".txt" : ".gom" );
+		ofstream ofs( f.str().c_str() );
+		if ( !ofs.is_open() || !writeText( ofs, record, engine ) )
+		{
+			cerr << f.str() << ": can't write" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if ( prefix_.size() )
+		cout << n << " records written" << endl;
+	return EXIT_SUCCESS;
+}
+
+static int info( const string& in_ )
+//-------------------------------------------------------------------------------
+{
+	GameFile file;
+	if ( !file.open( in_ ) )
+	{
+		cerr << in_ << ": no game file" << endl;
+		return EXIT_FAILURE;
+	}
+	double start = now();
+	GameRecord record;
+	size_t offset = file.first();
+	size_t games = 0;
+	size_t positions = 0;
+	size_t moves = 0;
+	int results[3 + 1] = { 0, 0, 0, 0 };
+	while ( file.read( offset, record ) )
+	{
+		moves += record.moves.size();
+		if ( record.type == GameRecord::GR_Position )
+			positions++;
+		else
+		{
+			games++;
+			results[record.result & 3]++;
+		}
+	}
+	double elapsed = now() - start;
+	size_t records = games + positions;
+	if ( file.indexed() && file.count() != records )
+		cerr << in_ << ": index has " << file.count() << " records, read " << records << endl;
+	cout << in_ << ": board size " << file.size() << ", " << ( file.indexed() ? "indexed" : "no index" ) << endl;
+	cout << "games:          " << games << " (first player wins " << results[1] << ", second player wins "
+	     << results[2] << ", draws " << results[3] << ", open " << results[0] << ")" << endl;
+	cout << "positions:      " << positions << endl;
+	cout << "moves/pieces:   " << moves << " (" << fixed << setprecision( 2 )
+	     << ( moves ? (double)( offset - file.first() ) / moves : 0. ) << " bytes each incl. record header)" << endl;
+	cout << "read:           " << setprecision( 3 ) << elapsed << " s (" << setprecision( 0 )
+	     << ( elapsed > 0 ? records / elapsed : 0. ) << " records/sec)" << endl;
+	return EXIT_SUCCESS;
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	string out;
+	string prefix;
+	string mode;
+	bool index = true;
+	vector<string> files;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		string value = i + 1 < argc_ ? argv_[i + 1] : "";
+		if ( arg == "-o" )
+			out = value, mode = arg, i++;
+		else if ( arg == "-x" )
+			prefix = value, mode = arg, i++;
+		else if ( arg == "-cat" || arg == "-info" )
+			mode = arg;
+		else if ( arg == "-size" )
+			boardSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-noindex" )
+			index = false;
+		else if ( arg[0] != '-' )
+			files.push_back( arg );
+		else
+			files.clear(), i = argc_;
+	}
+	if ( files.empty() || mode.empty() || ( mode != "-o" && files.size() != 1 ) ||
+	     ( boardSize != Engine::BS_Small && boardSize != Engine::BS_Medium && boardSize != Engine::BS_Standard ) )
+	{
+		cerr << "usage: " << argv_[0] << " -o games.gmk [-size 11|15|19] [-noindex] game.gom|board.txt..." << endl <<
+		     "\t| -x prefix games.gmk | -cat games.gmk | -info games.gmk" << endl;
+		return EXIT_FAILURE;
+	}
+	if ( mode == "-o" )
+		return convert( out, files, index );
+	if ( mode == "-info" )
+		return info( files[0] );
+	return extract( files[0], prefix );
+}
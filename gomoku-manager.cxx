@@ -0,0 +1,366 @@
+/*
+
+ FLTK Gomoku - mock Gomocup manager
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Runs two brains speaking the Gomocup protocol (e.g. pbrain-gomoku) as
+ child processes and plays games between them, alternating the colours:
+ INFO limits, START, BEGIN/TURN, END. Checks the responses (format,
+ legality, time per move and match) and reports the results, the move
+ times and the latency of the protocol path (ABOUT round trips).
+ Games can be written in the format of the GUI's "Save game..".
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+static int games = 2;
+static int boardSize = Engine::BS_Medium;
+static long timeoutTurn = 1000; // ms
+static long timeoutMatch = 0; // ms (0 = no limit)
+static long maxMemory = 64 * 1024 * 1024; // bytes
+static double tolerance = 0.1; // s beyond timeout_turn before a loss
+static string outDir;
+static bool verbose = false;
+
+static double now()
+//-------------------------------------------------------------------------------
+{
+	return chrono::duration<double>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+//-------------------------------------------------------------------------------
+class Brain
+//-------------------------------------------------------------------------------
+{
+	// a brain process, connected by pipes to its stdin and stdout
+public:
+	Brain( const string& cmd_ ) : _cmd( cmd_ ), _pid( -1 ), _in( -1 ), _out( -1 ), _time( 0 ) {}
+	~Brain() { stop(); }
+	bool start();
+	void stop();
+	void send( const string& line_ );
+	// next response line within timeout_ seconds (MESSAGE/DEBUG lines
+	// are shown with -v and skipped)
+	bool receive( string& line_, double timeout_ );
+	const string& cmd() const { return _cmd; }
+	double& time() { return _time; } // used in the current game
+private:
+	string _cmd;
+	pid_t _pid;
+	int _in; // (brain's stdin)
+	int _out; // (brain's stdout)
+	string _buffer;
+	double _time;
+};
+
+bool Brain::start()
+//-------------------------------------------------------------------------------
+{
+	int in[2], out[2];
+	if ( pipe( in ) || pipe( out ) )
+		return false;
+	_pid = fork();
+	if ( _pid < 0 )
+		return false;
+	if ( _pid == 0 )
+	{
+		dup2( in[0], 0 );
+		dup2( out[1], 1 );
+		close( in[0] ); close( in[1] );
+		close( out[0] ); close( out[1] );
+		execl( "/bin/sh", "sh", "-c", _cmd.c_str(), (char *)0 );
+		_exit( 127 );
+	}
+	close( in[0] );
+	close( out[1] );
+	_in = in[1];
+	_out = out[0];
+	return true;
+}
+
+void Brain::stop()
+//-------------------------------------------------------------------------------
+{
+	if ( _pid <= 0 )
+		return;
+	send( "END" );
+	close( _in );
+	// (a brain that does not end in time is killed)
+	int status;
+	for ( int i = 0; i < 100 && waitpid( _pid, &status, WNOHANG ) == 0; i++ )
+		usleep( 10000 );
+	if ( waitpid( _pid, &status, WNOHANG ) == 0 )
+	{
+		kill( _pid, SIGKILL );
+		waitpid( _pid, &status, 0 );
+	}
+	close( _out );
+	_pid = -1;
+}
+
+void Brain::send( const string& line_ )
+//-------------------------------------------------------------------------------
+{
+	if ( verbose )
+		cerr << "-> " << _cmd << ": " << line_ << endl;
+	string l = line_ + "\n";
+	if ( write( _in, l.data(), l.size() ) != (ssize_t)l.size() )
+		cerr << _cmd << ": write failed" << endl;
+}
+
+bool Brain::receive( string& line_, double timeout_ )
+//-------------------------------------------------------------------------------
+{
+	double end = now() + timeout_;
+	for ( ;; )
+	{
+		size_t nl = _buffer.find( '\n' );
+		if ( nl != string::npos )
+		{
+			line_ = _buffer.substr( 0, nl );
+			_buffer.erase( 0, nl + 1 );
+			if ( line_.size() && line_.back() == '\r' )
+				line_.pop_back();
+			if ( verbose )
+				cerr << "<- " << _cmd << ": " << line_ << endl;
+			if ( line_.compare( 0, 7, "MESSAGE" ) && line_.compare( 0, 5, "DEBUG" ) )
+				return true;
+			continue;
+		}
+		int ms = (int)( ( end - now() ) * 1000 );
+		pollfd p = { _out, POLLIN, 0 };
+		if ( ms <= 0 || poll( &p, 1, ms ) <= 0 )
+			return false;
+		char buf[4096];
+		ssize_t n = read( _out, buf, sizeof( buf ) );
+		if ( n <= 0 )
+			return false;
+		_buffer.append( buf, n );
+	}
+}
+
+static bool parseMove( const string& s_, Move& move_ )
+//-------------------------------------------------------------------------------
+{
+	int x, y;
+	char c;
+	if ( sscanf( s_.c_str(), "%d,%d%c", &x, &y, &c ) != 2 ||
+	     x < 0 || x >= boardSize || y < 0 || y >= boardSize )
+		return false;
+	move_.init( x + 1, y + 1 );
+	return true;
+}
+
+static void saveGame( int game_, const vector<Move>& moves_, const Engine& engine_ )
+//-------------------------------------------------------------------------------
+{
+	ostringstream f;
+	f << outDir << "/game-" << setw( 4 ) << setfill( '0' ) << game_ + 1 << ".gom";
+	ofstream ofs( f.str().c_str() );
+	if ( !ofs.is_open() )
+	{
+		cerr << f.str() << ": can't write" << endl;
+		return;
+	}
+	engine_.dumpGame( ofs, moves_, 1 );
+}
+
+// move times of all games
+static double maxMoveTime = 0;
+static double totalMoveTime = 0;
+static long totalMoves = 0;
+
+static int playGame( Brain *brain_[2 + 1], Engine& board_, vector<Move>& moves_, string& reason_ )
+//-------------------------------------------------------------------------------
+{
+	// brain_[1] begins, returns the winner (0 = draw), reason_ tells why
+	board_.clearBoard();
+	moves_.clear();
+	for ( int who = 1; who <= 2; who++ )
+	{
+		Brain& b = *brain_[who];
+		b.time() = 0;
+		b.send( "INFO timeout_turn " + to_string( timeoutTurn ) );
+		b.send( "INFO timeout_match " + to_string( timeoutMatch ) );
+		b.send( "INFO max_memory " + to_string( maxMemory ) );
+		b.send( "INFO rule 1" );
+		b.send( "START " + to_string( boardSize ) );
+		string r;
+		if ( !b.receive( r, 5 ) || r != "OK" )
+		{
+			reason_ = "START: '" + r + "'";
+			return 3 - who;
+		}
+	}
+	int who = 1;
+	while ( !board_.full() )
+	{
+		Brain& b = *brain_[who];
+		if ( timeoutMatch > 0 )
+			b.send( "INFO time_left " + to_string( (long)( timeoutMatch - b.time() * 1000 ) ) );
+		ostringstream cmd;
+		if ( moves_.empty() )
+			cmd << "BEGIN";
+		else
+			cmd << "TURN " << moves_.back().x - 1 << ',' << moves_.back().y - 1;
+		double limit = timeoutTurn > 0 ? timeoutTurn / 1000. : 1e9;
+		if ( timeoutMatch > 0 && timeoutMatch / 1000. - b.time() < limit )
+			limit = timeoutMatch / 1000. - b.time();
+		double start = now();
+		b.send( cmd.str() );
+		string r;
+		bool received = b.receive( r, limit + tolerance + 1 );
+		double t = now() - start;
+		b.time() += t;
+		Move move;
+		if ( !received || t > limit + tolerance )
+		{
+			reason_ = "time (" + to_string( t ) + " s)";
+			return 3 - who;
+		}
+		if ( !parseMove( r, move ) || board_.at( move.x, move.y ) )
+		{
+			reason_ = "invalid move '" + r + "'";
+			return 3 - who;
+		}
+		if ( t > maxMoveTime )
+			maxMoveTime = t;
+		totalMoveTime += t;
+		totalMoves++;
+		board_.makeMove( move, who );
+		moves_.push_back( move );
+		if ( board_.checkWin( move.x, move.y ) )
+		{
+			reason_ = "five";
+			return who;
+		}
+		who = 3 - who;
+	}
+	reason_ = "board full";
+	return 0;
+}
+
+static double latency( Brain& brain_, int n_ )
+//-------------------------------------------------------------------------------
+{
+	// average round trip of a command without search (ABOUT) in seconds
+	// (after the brain has started up)
+	string r;
+	brain_.send( "ABOUT" );
+	if ( !brain_.receive( r, 10 ) )
+		return -1;
+	double start = now();
+	for ( int i = 0; i < n_; i++ )
+	{
+		brain_.send( "ABOUT" );
+		if ( !brain_.receive( r, 5 ) )
+			return -1;
+	}
+	return ( now() - start ) / n_;
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	vector<string> cmds;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		string value = i + 1 < argc_ ? argv_[i + 1] : "";
+		if ( arg == "-n" )
+			games = atoi( value.c_str() ), i++;
+		else if ( arg == "-size" )
+			boardSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-turn" )
+			timeoutTurn = atol( value.c_str() ), i++;
+		else if ( arg == "-match" )
+			timeoutMatch = atol( value.c_str() ), i++;
+		else if ( arg == "-memory" )
+			maxMemory = atol( value.c_str() ), i++;
+		else if ( arg == "-o" )
+			outDir = value, i++;
+		else if ( arg == "-v" )
+			verbose = true;
+		else if ( arg[0] != '-' )
+			cmds.push_back( arg );
+		else
+			cmds.clear(), i = argc_;
+	}
+	if ( cmds.empty() || cmds.size() > 2 || boardSize < 5 || boardSize > Engine::BS_Max )
+	{
+		cerr << "usage: " << argv_[0] << " [-n games] [-size n] [-turn ms] [-match ms] [-memory bytes]" << endl <<
+		     "\t[-o directory] [-v] brain [brain2]" << endl;
+		return EXIT_FAILURE;
+	}
+	if ( cmds.size() == 1 )
+		cmds.push_back( cmds[0] );
+	signal( SIGPIPE, SIG_IGN );
+	Brain b1( cmds[0] ), b2( cmds[1] );
+	if ( !b1.start() || !b2.start() )
+	{
+		cerr << "can't start the brains" << endl;
+		return EXIT_FAILURE;
+	}
+	double l = latency( b1, 100 );
+	if ( l < 0 )
+	{
+		cerr << b1.cmd() << ": no response to ABOUT" << endl;
+		return EXIT_FAILURE;
+	}
+	cout << "protocol round trip: " << fixed << setprecision( 1 ) << l * 1e6 << " us" << endl;
+
+	int wins[2 + 1] = { 0, 0, 0 }; // [0] = draws
+	vector<Move> moves;
+	Engine engine( boardSize );
+	for ( int game = 0; game < games; game++ )
+	{
+		// alternate the colours
+		Brain *brain[2 + 1] = { 0, game % 2 ? &b2 : &b1, game % 2 ? &b1 : &b2 };
+		string reason;
+		int winner = playGame( brain, engine, moves, reason );
+		if ( outDir.size() )
+			saveGame( game, moves, engine );
+		int brainWins = winner ? brain[winner] == &b1 ? 1 : 2 : 0;
+		wins[brainWins]++;
+		cout << "game " << game + 1 << ": " << moves.size() << " moves, " <<
+		     ( brainWins ? brainWins == 1 ? "brain 1 wins" : "brain 2 wins" : "draw" ) <<
+		     " (" << reason << ")" << endl;
+	}
+	cout << "brain 1:        " << wins[1] << endl
+	     << "brain 2:        " << wins[2] << endl
+	     << "draws:          " << wins[0] << endl
+	     << "move time:      avg " << setprecision( 3 ) << ( totalMoves ? totalMoveTime / totalMoves : 0 )
+	     << " s, max " << maxMoveTime << " s";
+	if ( timeoutTurn > 0 )
+		cout << " (limit " << timeoutTurn / 1000. << " s)";
+	cout << endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,247 @@
+/*
+
+ FLTK Gomoku - perft style validation of the evaluation
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Walks all move sequences up to a depth from a board file and counts the
+ leaves. At every leaf the evaluation of all empty cells for both colours
+ is hashed. This is done with a fresh ::count() of every cell (reference)
+ and with the incremental evaluation cache of the engine for each line
+ counter (scalar, bitboard, table). Different leaf counts or hashes are
+ reported as failure.
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+using namespace std;
+
+static const int PLAYER = 1;
+static const int COMPUTER = 2;
+
+//-------------------------------------------------------------------------------
+struct Perft
+//-------------------------------------------------------------------------------
+{
+	Engine& engine;
+	bool reference; // fresh ::count() instead of the engine's cache
+	bool near; // only moves at most 2 cells away from a piece
+	long nodes;
+	long leaves;
+	uint64_t hash;
+	Perft( Engine& engine_, bool reference_, bool near_ ) :
+		engine( engine_ ),
+		reference( reference_ ),
+		near( near_ ),
+		nodes( 0 ),
+		leaves( 0 ),
+		hash( 0xcbf29ce484222325ULL )
+	{}
+	void mix( uint64_t v_ )
+	{
+		// FNV-1a over 64 bit values
+		hash ^= v_;
+		hash *= 0x100000001b3ULL;
+	}
+	static int digest( const PosInfo& info_ )
+	{
+		// Everything the evaluation uses of a PosInfo. (The pattern table
+		// counts freedoms only up to its window and overlines only up
+		// to its length, but gives the same predicates.)
+		int n = info_.n > 5 ? 6 : info_.n;
+		return n | info_.gap << 3 | info_.canWin() << 4 | info_.single_freedom() << 5;
+	}
+	void leaf();
+	int moves( short *moves_ ) const;
+	void walk( int who_, int depth_ );
+};
+
+void Perft::leaf()
+//-------------------------------------------------------------------------------
+{
+	leaves++;
+	mix( engine.hash() );
+	int BS = engine.size();
+	Board board;
+	if ( reference )
+		memcpy( board, engine.board(), sizeof( board ) );
+	for ( int x = 1; x <= BS; x++ )
+	{
+		for ( int y = 1; y <= BS; y++ )
+		{
+			if ( engine.at( x, y ) )
+				continue;
+			for ( int who = 1; who <= 2; who++ )
+			{
+				Eval e;
+				if ( reference )
+				{
+					board[x][y] = who;
+					engine.countPos( x, y, e, board );
+					board[x][y] = 0;
+				}
+				else
+				{
+					Move m( x, y );
+					engine.evaluate( m, who );
+					e = m.eval;
+				}
+				uint64_t v = 0;
+				for ( int dir = 1; dir <= 4; dir++ )
+					v = v << 6 | digest( e.info[dir] );
+				mix( v << 16 | x << 8 | y << 2 | who );
+			}
+		}
+	}
+}
+
+int Perft::moves( short *moves_ ) const
+//-------------------------------------------------------------------------------
+{
+	int BS = engine.size();
+	int n = 0;
+	for ( int x = 1; x <= BS; x++ )
+	{
+		for ( int y = 1; y <= BS; y++ )
+		{
+			if ( engine.at( x, y ) )
+				continue;
+			bool ok = !near || !engine.pieces();
+			for ( int dx = -2; dx <= 2 && !ok; dx++ )
+				for ( int dy = -2; dy <= 2 && !ok; dy++ )
+					ok = engine.at( x + dx, y + dy ) > 0;
+			if ( ok )
+				moves_[n++] = x << 5 | y;
+		}
+	}
+	return n;
+}
+
+void Perft::walk( int who_, int depth_ )
+//-------------------------------------------------------------------------------
+{
+	nodes++;
+	if ( depth_ <= 0 )
+		return leaf();
+	short cells[Engine::BS_Max * Engine::BS_Max];
+	int n = moves( cells );
+	if ( !n )
+		return leaf();
+	for ( int i = 0; i < n; i++ )
+	{
+		int x = cells[i] >> 5;
+		int y = cells[i] & 31;
+		engine.setPiece( x, y, who_ );
+		if ( engine.checkWin( x, y ) )
+		{
+			nodes++;
+			leaf(); // game over
+		}
+		else
+			walk( 3 - who_, depth_ - 1 );
+		engine.removePiece( x, y );
+	}
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	int depth = 2;
+	bool near = false;
+	vector<string> files;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		if ( arg == "-depth" )
+		{
+			if ( ++i < argc_ )
+				depth = atoi( argv_[i] );
+		}
+		else if ( arg == "-near" )
+			near = true;
+		else
+			files.push_back( arg );
+	}
+	if ( files.empty() || depth < 0 )
+	{
+		cerr << "usage: " << argv_[0] << " [-depth plies] [-near] board.txt..." << endl;
+		return EXIT_FAILURE;
+	}
+
+	static const struct
+	{
+		const char *name;
+		bool reference;
+		Engine::Counter counter;
+	} MODES[] =
+	{
+		{ "reference", true, Engine::CT_Scalar },
+		{ "scalar", false, Engine::CT_Scalar },
+		{ "bitboard", false, Engine::CT_BitBoard },
+		{ "table", false, Engine::CT_Table }
+	};
+	int failed = 0;
+	for ( size_t f = 0; f < files.size(); f++ )
+	{
+		ifstream ifs( files[f].c_str() );
+		if ( !ifs.is_open() )
+		{
+			cerr << files[f] << ": can't open" << endl;
+			failed++;
+			continue;
+		}
+		Engine engine;
+		int last_moved = 0;
+		Move last_move;
+		engine.loadBoard( ifs, PLAYER, last_moved, last_move );
+		int who = last_moved == COMPUTER ? PLAYER : COMPUTER;
+		cout << files[f] << " (depth " << depth << ( near ? ", near moves" : "" ) << ")" << endl;
+
+		long leaves = 0;
+		uint64_t hash = 0;
+		for ( size_t m = 0; m < sizeof( MODES ) / sizeof( MODES[0] ); m++ )
+		{
+			engine.counter( MODES[m].counter );
+			Perft perft( engine, MODES[m].reference, near );
+			auto start = chrono::steady_clock::now();
+			perft.walk( who, depth );
+			double s = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+			bool ok = m == 0 || ( perft.leaves == leaves && perft.hash == hash );
+			if ( m == 0 )
+			{
+				leaves = perft.leaves;
+				hash = perft.hash;
+			}
+			failed += !ok;
+			cout << "  " << left << setw( 10 ) << MODES[m].name << right
+			     << setw( 12 ) << perft.leaves << " leaves"
+			     << setw( 12 ) << perft.nodes << " nodes"
+			     << "  hash " << hex << setw( 16 ) << setfill( '0' ) << perft.hash << dec << setfill( ' ' )
+			     << fixed << setprecision( 2 ) << setw( 9 ) << s << " s"
+			     << setw( 10 ) << (long)( perft.nodes / ( s > 0 ? s : 1e-6 ) ) << " nps"
+			     << ( ok ? "" : "  MISMATCH" ) << endl;
+		}
+	}
+	if ( failed )
+		cout << failed << " mismatches" << endl;
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,277 @@
+/*
+
+ FLTK Gomoku - headless self-play
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Plays games of the engine against itself without a window (optionally
+ several games in parallel) and reports games/sec, moves/sec, the average
+ game length and the results. The games can be written in the format of
+ the GUI's "Save game.." (one file per game) or into one binary game file
+ (-bin, see gamefile.h).
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include "book.h"
+#include "egdb.h"
+#include "gamefile.h"
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <ctime>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+// settings from the command line
+static int games = 10;
+static int parallel = 1;
+static double searchTime = 0.1;
+static int searchDepth = 0;
+static int searchWidth = 0;
+static int threads = 1;
+static int hashSize = 16;
+static int boardSize = Engine::BS_Standard;
+static int randomPlies = 2;
+static string outDir;
+static string outBinary;
+static GameWriter binaryGames; // (written under statsMutex)
+static uint64_t seed = 0;
+static TimeControl timeControl; // clocks (-tc), otherwise searchTime per move
+static std::shared_ptr<Book> book; // (shared by all engines)
+static std::shared_ptr<EndgameDB> egdb;
+static Weights weights;
+
+// results of all games
+static mutex statsMutex;
+static int wins[2 + 1]; // [0] = draws
+static long totalMoves = 0;
+static int timeLosses = 0;
+
+static int playGame( vector<Move>& moves_, Engine& engine_ )
+//-------------------------------------------------------------------------------
+{
+	// play one game, colour 1 begins, returns the winner (0 = draw)
+	// (with clocks a side whose time is up loses)
+	engine_.clearBoard();
+	moves_.clear();
+	TimeControl clock[2 + 1] = { timeControl, timeControl, timeControl };
+	int who = 1;
+	while ( !engine_.full() )
+	{
+		Move move;
+		engine_.searchTime( clock[who].budget( engine_.pieces(), engine_.size() ) );
+		auto start = chrono::steady_clock::now();
+		// some random moves at the start, so the games differ
+		bool found = (int)moves_.size() < randomPlies ? engine_.randomMove( move ) :
+		             engine_.findMove( move, who ) || engine_.randomMove( move );
+		if ( !found )
+			break;
+		clock[who].used( chrono::duration<double>( chrono::steady_clock::now() - start ).count() );
+		if ( clock[who].expired() )
+		{
+			lock_guard<mutex> lock( statsMutex );
+			timeLosses++;
+			return 3 - who;
+		}
+		engine_.makeMove( move, who );
+		moves_.push_back( move );
+		if ( engine_.checkWin( move.x, move.y ) )
+			return who;
+		who = 3 - who;
+	}
+	return 0;
+}
+
+static void saveGame( int game_, const vector<Move>& moves_, const Engine& engine_ )
+//-------------------------------------------------------------------------------
+{
+	ostringstream f;
+	f << outDir << "/game-" << setw( 4 ) << setfill( '0' ) << game_ + 1 << ".gom";
+	ofstream ofs( f.str().c_str() );
+	if ( !ofs.is_open() )
+	{
+		cerr << f.str() << ": can't write" << endl;
+		return;
+	}
+	engine_.dumpGame( ofs, moves_, 1 );
+}
+
+static void worker( atomic<int>& next_ )
+//-------------------------------------------------------------------------------
+{
+	Engine engine( boardSize );
+	if ( searchDepth )
+		engine.searchDepth( searchDepth );
+	if ( searchWidth )
+		engine.searchWidth( searchWidth );
+	engine.threads( threads );
+	engine.hashSize( hashSize );
+	engine.book( book );
+	engine.endgame( egdb );
+	engine.weights( weights );
+	vector<Move> moves;
+	moves.reserve( boardSize * boardSize );
+	int game;
+	while ( ( game = next_++ ) < games )
+	{
+		// each game its own sequence, independent of the worker playing it
+		engine.seed( seed + game );
+		int winner = playGame( moves, engine );
+		if ( outDir.size() )
+			saveGame( game, moves, engine );
+		lock_guard<mutex> lock( statsMutex );
+		if ( outBinary.size() )
+		{
+			GameRecord record;
+			record.moves = moves;
+			record.result = winner ? winner : 3;
+			binaryGames.write( record );
+		}
+		wins[winner]++;
+		totalMoves += moves.size();
+		cout << "game " << game + 1 << ": " << moves.size() << " moves, " <<
+		     ( winner ? winner == 1 ? "first player wins" : "second player wins" : "draw" ) << endl;
+	}
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		string value = i + 1 < argc_ ? argv_[i + 1] : "";
+		if ( arg == "-n" )
+			games = atoi( value.c_str() ), i++;
+		else if ( arg == "-j" )
+			parallel = atoi( value.c_str() ), i++;
+		else if ( arg == "-time" )
+			searchTime = atof( value.c_str() ), i++;
+		else if ( arg == "-depth" )
+			searchDepth = atoi( value.c_str() ), i++;
+		else if ( arg == "-width" )
+			searchWidth = atoi( value.c_str() ), i++;
+		else if ( arg == "-threads" )
+			threads = atoi( value.c_str() ), i++;
+		else if ( arg == "-hash" )
+			hashSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-size" )
+			boardSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-random" )
+			randomPlies = atoi( value.c_str() ), i++;
+		else if ( arg == "-o" )
+			outDir = value, i++;
+		else if ( arg == "-bin" )
+			outBinary = value, i++;
+		else if ( arg == "-tc" )
+		{
+			if ( !timeControl.parse( value ) )
+			{
+				cerr << "invalid time control '" << value << "'" << endl;
+				return EXIT_FAILURE;
+			}
+			i++;
+		}
+		else if ( arg == "-book" )
+		{
+			book = std::make_shared<Book>();
+			if ( !book->load( value ) )
+			{
+				cerr << value << ": no book" << endl;
+				return EXIT_FAILURE;
+			}
+			i++;
+		}
+		else if ( arg == "-egdb" )
+		{
+			egdb = std::make_shared<EndgameDB>();
+			if ( !egdb->load( value ) )
+			{
+				cerr << value << ": no endgame database" << endl;
+				return EXIT_FAILURE;
+			}
+			i++;
+		}
+		else if ( arg == "-weights" )
+		{
+			if ( !weights.load( value ) )
+			{
+				cerr << value << ": invalid weights" << endl;
+				return EXIT_FAILURE;
+			}
+			i++;
+		}
+		else if ( arg == "-seed" )
+			seed = strtoull( value.c_str(), 0, 10 ), i++;
+		else
+		{
+			cerr << "usage: " << argv_[0] << " [-n games] [-j parallel games] [-time seconds]" << endl <<
+			     "\t[-depth plies] [-width moves] [-threads n] [-hash MB] [-size 11|15|19]" << endl <<
+			     "\t[-tc seconds[+increment]] [-book file] [-egdb file] [-random plies] [-seed n] [-o directory]" << endl <<
+			     "\t[-bin games.gmk] [-weights file]" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if ( games <= 0 || parallel <= 0 ||
+	     ( boardSize != Engine::BS_Small && boardSize != Engine::BS_Medium && boardSize != Engine::BS_Standard ) )
+	{
+		cerr << "invalid arguments" << endl;
+		return EXIT_FAILURE;
+	}
+	if ( timeControl.mode() == TimeControl::TC_Move )
+		timeControl = TimeControl( TimeControl::TC_Move, searchTime );
+	if ( !seed )
+		seed = time( 0 );
+	cout << "seed " << seed << endl;
+	if ( outBinary.size() && !binaryGames.open( outBinary, boardSize ) )
+	{
+		cerr << outBinary << ": can't write" << endl;
+		return EXIT_FAILURE;
+	}
+
+	auto start = chrono::steady_clock::now();
+	atomic<int> next( 0 );
+	vector<thread> workers;
+	for ( int i = 0; i < parallel; i++ )
+		workers.emplace_back( worker, ref( next ) );
+	for ( size_t i = 0; i < workers.size(); i++ )
+		workers[i].join();
+	double elapsed = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+	if ( outBinary.size() && !binaryGames.close() )
+		cerr << outBinary << ": write error" << endl;
+
+	cout << endl << games << " games in " << fixed << setprecision( 2 ) << elapsed << " s ("
+	     << parallel << " parallel, ";
+	if ( timeControl.mode() == TimeControl::TC_Move )
+		cout << "search time " << searchTime << " s)" << endl;
+	else
+		cout << "clock " << timeControl.time() << " s + " << timeControl.increment() << " s)" << endl;
+	cout << "games/sec:      " << setprecision( 3 ) << games / elapsed << endl;
+	cout << "moves/sec:      " << setprecision( 1 ) << totalMoves / elapsed << endl;
+	cout << "average length: " << setprecision( 1 ) << (double)totalMoves / games << " moves" << endl;
+	cout << "first player:   " << wins[1] << " (" << 100. * wins[1] / games << "%)" << endl;
+	cout << "second player:  " << wins[2] << " (" << 100. * wins[2] / games << "%)" << endl;
+	cout << "draws:          " << wins[0] << " (" << 100. * wins[0] / games << "%)" << endl;
+	if ( timeControl.mode() != TimeControl::TC_Move )
+		cout << "lost on time:   " << timeLosses << endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,588 @@
+/*
+
+ FLTK Gomoku - analysis server
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ A long running engine process for analysing many positions: listens on a
+ Unix domain socket (-socket) or a localhost TCP port (-port) and analyses
+ the positions sent by its clients on a pool of threads (each with its
+ own engine), streaming back the results as they are finished.
+
+ Requests (one per line, a connection keeps its settings):
+   time <seconds>           search time per position (default -time)
+   depth <plies>            max. search depth (0 = engine default)
+   board <id> [who]         followed by a board in the format of
+                            Engine::dumpBoard() (label line and one line
+                            per row, 'p' = colour 1, 'c' = colour 2); who
+                            is the colour to move, by default the colour
+                            that did not make the last (upper case) move
+   packed <id> <size> <who> followed by (size * size + 3) / 4 bytes, the
+                            cells row by row with 2 bits each (0 = empty,
+                            1/2 = colour), the first cell in the low bits
+                            (an invalid size closes the connection)
+   sync                     answered by "done" when all positions sent
+                            before are answered
+   quit                     close the connection
+ Responses:
+   result <id> <move> <score> <depth> <nodes> <principal variation...>
+   error <id> <message>
+
+ With -connect it is the client: sends the board files (-packed: in the
+ binary encoding) and prints the results and positions/sec.
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include <vector>
+#include <deque>
+#include <memory>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace std;
+
+static string socketPath;
+static int port = 0;
+static int threads = thread::hardware_concurrency();
+static int hashSize = 16; // per thread
+static double searchTime = 0.1;
+
+static double now()
+//-------------------------------------------------------------------------------
+{
+	return chrono::duration<double>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+static int labels( const string& line_ )
+//-------------------------------------------------------------------------------
+{
+	// board size from the label line of Engine::dumpBoard()
+	istringstream is( line_ );
+	string label;
+	int n = 0;
+	while ( is >> label )
+		n++;
+	return n;
+}
+
+//-------------------------------------------------------------------------------
+class Reader
+//-------------------------------------------------------------------------------
+{
+	// buffered reading of lines and bytes from a socket
+public:
+	Reader( int fd_ ) : _fd( fd_ ) {}
+	bool line( string& line_ );
+	bool bytes( string& bytes_, size_t n_ );
+private:
+	bool fill();
+private:
+	int _fd;
+	string _buffer;
+};
+
+bool Reader::fill()
+//-------------------------------------------------------------------------------
+{
+	char buf[65536];
+	ssize_t n = recv( _fd, buf, sizeof( buf ), 0 );
+	if ( n <= 0 )
+		return false;
+	_buffer.append( buf, n );
+	return true;
+}
+
+bool Reader::line( string& line_ )
+//-------------------------------------------------------------------------------
+{
+	size_t nl;
+	while ( ( nl = _buffer.find( '\n' ) ) == string::npos )
+		if ( !fill() )
+			return false;
+	line_ = _buffer.substr( 0, nl );
+	_buffer.erase( 0, nl + 1 );
+	if ( line_.size() && line_.back() == '\r' )
+		line_.pop_back();
+	return true;
+}
+
+bool Reader::bytes( string& bytes_, size_t n_ )
+//-------------------------------------------------------------------------------
+{
+	while ( _buffer.size() < n_ )
+		if ( !fill() )
+			return false;
+	bytes_ = _buffer.substr( 0, n_ );
+	_buffer.erase( 0, n_ );
+	return true;
+}
+
+//-------------------------------------------------------------------------------
+class Connection
+//-------------------------------------------------------------------------------
+{
+	// a client: its socket (closed when the last job is answered)
+	// and the number of its positions not yet answered
+public:
+	Connection( int fd_ ) : _fd( fd_ ), _pending( 0 ) {}
+	~Connection() { close( _fd ); }
+	int fd() const { return _fd; }
+	void send( const string& line_ );
+	void submitted();
+	void answered( const string& line_ );
+	void sync();
+private:
+	int _fd;
+	mutex _mutex;
+	condition_variable _done;
+	int _pending;
+};
+
+void Connection::send( const string& line_ )
+//-------------------------------------------------------------------------------
+{
+	lock_guard<mutex> lock( _mutex );
+	string l = line_ + "\n";
+	::send( _fd, l.data(), l.size(), MSG_NOSIGNAL );
+}
+
+void Connection::submitted()
+//-------------------------------------------------------------------------------
+{
+	lock_guard<mutex> lock( _mutex );
+	_pending++;
+}
+
+void Connection::answered( const string& line_ )
+//-------------------------------------------------------------------------------
+{
+	send( line_ );
+	lock_guard<mutex> lock( _mutex );
+	if ( --_pending == 0 )
+		_done.notify_all();
+}
+
+void Connection::sync()
+//-------------------------------------------------------------------------------
+{
+	unique_lock<mutex> lock( _mutex );
+	_done.wait( lock, [this]{ return _pending == 0; } );
+}
+
+// a position to analyse
+struct Job
+{
+	shared_ptr<Connection> conn;
+	string id;
+	string board; // text (Engine::dumpBoard())
+	string packed; // or cells with 2 bits each
+	int size = 0;
+	int who = 0;
+	double time = 0;
+	int depth = 0;
+};
+
+//-------------------------------------------------------------------------------
+class JobQueue
+//-------------------------------------------------------------------------------
+{
+public:
+	void push( Job&& job_ );
+	// next job (false when closed and empty)
+	bool pop( Job& job_ );
+	void close();
+private:
+	mutex _mutex;
+	condition_variable _ready;
+	deque<Job> _jobs;
+	bool _closed = false;
+};
+
+void JobQueue::push( Job&& job_ )
+//-------------------------------------------------------------------------------
+{
+	{
+		lock_guard<mutex> lock( _mutex );
+		_jobs.push_back( move( job_ ) );
+	}
+	_ready.notify_one();
+}
+
+bool JobQueue::pop( Job& job_ )
+//-------------------------------------------------------------------------------
+{
+	unique_lock<mutex> lock( _mutex );
+	_ready.wait( lock, [this]{ return _closed || !_jobs.empty(); } );
+	if ( _jobs.empty() )
+		return false;
+	job_ = move( _jobs.front() );
+	_jobs.pop_front();
+	return true;
+}
+
+void JobQueue::close()
+//-------------------------------------------------------------------------------
+{
+	{
+		lock_guard<mutex> lock( _mutex );
+		_closed = true;
+	}
+	_ready.notify_all();
+}
+
+static JobQueue jobs;
+
+static bool setup( Engine& engine_, const Job& job_, int& who_ )
+//-------------------------------------------------------------------------------
+{
+	// position of the job on the board of engine_
+	engine_.size( job_.size );
+	who_ = job_.who;
+	if ( job_.packed.size() )
+	{
+		for ( int i = 0; i < job_.size * job_.size; i++ )
+		{
+			int c = ( job_.packed[i / 4] >> ( i % 4 * 2 ) ) & 3;
+			if ( c == 1 || c == 2 )
+				engine_.setPiece( i % job_.size + 1, i / job_.size + 1, c );
+			else if ( c )
+				return false;
+		}
+	}
+	else
+	{
+		istringstream is( job_.board );
+		int last_moved;
+		Move last_move;
+		if ( !engine_.loadBoard( is, 1, last_moved, last_move ) )
+			return false;
+		if ( !who_ )
+			who_ = last_moved == 2 ? 1 : 2;
+	}
+	return who_ == 1 || who_ == 2;
+}
+
+static string analyse( Engine& engine_, const Job& job_, int defaultDepth_ )
+//-------------------------------------------------------------------------------
+{
+	int who;
+	if ( !setup( engine_, job_, who ) )
+		return "error " + job_.id + " invalid position";
+	engine_.searchTime( job_.time );
+	engine_.searchDepth( job_.depth ? job_.depth : defaultDepth_ );
+	Move move;
+	if ( !engine_.findMove( move, who ) && !engine_.randomMove( move ) )
+		return "error " + job_.id + " no move";
+	vector<Move> pv;
+	engine_.principalVariation( move, who, pv );
+	ostringstream os;
+	os << "result " << job_.id << ' ' << move.asString() << ' ' << engine_.score() << ' '
+	   << engine_.depth() << ' ' << engine_.nodes();
+	for ( size_t i = 0; i < pv.size(); i++ )
+		os << ' ' << pv[i].asString();
+	return os.str();
+}
+
+static void worker( int n_ )
+//-------------------------------------------------------------------------------
+{
+	Engine engine;
+	engine.hashSize( hashSize );
+	engine.seed( n_ + 1 );
+	int defaultDepth = engine.searchDepth();
+	Job job;
+	while ( jobs.pop( job ) )
+	{
+		job.conn->answered( analyse( engine, job, defaultDepth ) );
+		job.conn.reset(); // (closes the socket after the last job)
+	}
+}
+
+static void serve( shared_ptr<Connection> conn_ )
+//-------------------------------------------------------------------------------
+{
+	// read the requests of a client
+	Reader in( conn_->fd() );
+	double time = searchTime;
+	int depth = 0;
+	string line;
+	while ( in.line( line ) )
+	{
+		istringstream is( line );
+		string cmd;
+		is >> cmd;
+		Job job;
+		if ( cmd.empty() )
+			continue;
+		else if ( cmd == "time" )
+			is >> time;
+		else if ( cmd == "depth" )
+			is >> depth;
+		else if ( cmd == "board" )
+		{
+			// label line gives the size, then one line per row
+			is >> job.id >> job.who;
+			string l;
+			if ( !in.line( l ) )
+				break;
+			job.size = labels( l );
+			job.board = l + "\n";
+			for ( int y = 0; y < job.size && in.line( l ); y++ )
+				job.board += l + "\n";
+		}
+		else if ( cmd == "packed" )
+		{
+			is >> job.id >> job.size >> job.who;
+			if ( job.size < 5 || job.size > Engine::BS_Standard )
+			{
+				// (the payload of an invalid size can't be skipped safely, the
+				// stream is out of sync: closes the connection)
+				conn_->send( "error " + ( job.id.empty() ? "-" : job.id ) + " invalid board size" );
+				break;
+			}
+			if ( !in.bytes( job.packed, ( job.size * job.size + 3 ) / 4 ) )
+				break;
+		}
+		else if ( cmd == "sync" )
+		{
+			conn_->sync();
+			conn_->send( "done" );
+		}
+		else if ( cmd == "quit" )
+			break;
+		else
+			conn_->send( "error - unknown request '" + cmd + "'" );
+		if ( cmd == "board" || cmd == "packed" )
+		{
+			if ( job.id.empty() || job.size < 5 || job.size > Engine::BS_Standard )
+			{
+				conn_->send( "error " + ( job.id.empty() ? "-" : job.id ) + " invalid request" );
+				continue;
+			}
+			job.conn = conn_;
+			job.time = time;
+			job.depth = depth;
+			conn_->submitted();
+			jobs.push( move( job ) );
+		}
+	}
+}
+
+static int listenSocket()
+//-------------------------------------------------------------------------------
+{
+	int fd;
+	if ( port )
+	{
+		fd = socket( AF_INET, SOCK_STREAM, 0 );
+		int on = 1;
+		setsockopt( fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof( on ) );
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons( port );
+		addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+		if ( bind( fd, (sockaddr *)&addr, sizeof( addr ) ) )
+			return -1;
+	}
+	else
+	{
+		fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+		sockaddr_un addr = {};
+		addr.sun_family = AF_UNIX;
+		strncpy( addr.sun_path, socketPath.c_str(), sizeof( addr.sun_path ) - 1 );
+		unlink( socketPath.c_str() );
+		if ( bind( fd, (sockaddr *)&addr, sizeof( addr ) ) )
+			return -1;
+	}
+	return listen( fd, 16 ) ? -1 : fd;
+}
+
+static int connectSocket()
+//-------------------------------------------------------------------------------
+{
+	int fd;
+	int rc;
+	if ( port )
+	{
+		fd = socket( AF_INET, SOCK_STREAM, 0 );
+		sockaddr_in addr = {};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons( port );
+		addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+		rc = connect( fd, (sockaddr *)&addr, sizeof( addr ) );
+	}
+	else
+	{
+		fd = socket( AF_UNIX, SOCK_STREAM, 0 );
+		sockaddr_un addr = {};
+		addr.sun_family = AF_UNIX;
+		strncpy( addr.sun_path, socketPath.c_str(), sizeof( addr.sun_path ) - 1 );
+		rc = connect( fd, (sockaddr *)&addr, sizeof( addr ) );
+	}
+	if ( rc )
+	{
+		close( fd );
+		return -1;
+	}
+	return fd;
+}
+
+static int server()
+//-------------------------------------------------------------------------------
+{
+	int fd = listenSocket();
+	if ( fd < 0 )
+	{
+		cerr << ( port ? "port " + to_string( port ) : socketPath ) << ": " << strerror( errno ) << endl;
+		return EXIT_FAILURE;
+	}
+	cout << "listening on " << ( port ? "127.0.0.1:" + to_string( port ) : socketPath )
+	     << ", " << threads << " threads" << endl;
+	vector<thread> pool;
+	for ( int i = 0; i < threads; i++ )
+		pool.emplace_back( worker, i );
+	int client;
+	while ( ( client = accept( fd, 0, 0 ) ) >= 0 )
+	{
+		// (a client not reading its results must not block a thread forever)
+		timeval timeout = { 30, 0 };
+		setsockopt( client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof( timeout ) );
+		thread( serve, make_shared<Connection>( client ) ).detach();
+	}
+	jobs.close();
+	for ( size_t i = 0; i < pool.size(); i++ )
+		pool[i].join();
+	return EXIT_SUCCESS;
+}
+
+static int client( const vector<string>& files_, bool packed_ )
+//-------------------------------------------------------------------------------
+{
+	// send all boards, then print the results up to "done"
+	int fd = connectSocket();
+	if ( fd < 0 )
+	{
+		cerr << ( port ? "port " + to_string( port ) : socketPath ) << ": " << strerror( errno ) << endl;
+		return EXIT_FAILURE;
+	}
+	double start = now();
+	ostringstream os;
+	os << "time " << searchTime << "\n";
+	Engine engine;
+	for ( size_t i = 0; i < files_.size(); i++ )
+	{
+		// (only the board, without the comments after it)
+		ifstream ifs( files_[i].c_str() );
+		string l;
+		getline( ifs, l );
+		int BS = labels( l );
+		string text = l + "\n";
+		for ( int y = 0; y < BS && getline( ifs, l ); y++ )
+			text += l + "\n";
+		if ( !packed_ )
+		{
+			os << "board " << i << "\n" << text;
+			continue;
+		}
+		istringstream is( text );
+		int last_moved;
+		Move last_move;
+		engine.size( BS );
+		engine.loadBoard( is, 1, last_moved, last_move );
+		string cells( ( BS * BS + 3 ) / 4, '\0' );
+		for ( int c = 0; c < BS * BS; c++ )
+			cells[c / 4] |= engine.at( c % BS + 1, c / BS + 1 ) << ( c % 4 * 2 );
+		os << "packed " << i << ' ' << BS << ' ' << ( last_moved == 2 ? 1 : 2 ) << "\n" << cells;
+	}
+	os << "sync\nquit\n";
+	// (sent by a thread, the results are read meanwhile)
+	string request = os.str();
+	thread sender( [fd, &request]()
+	{
+		if ( ::send( fd, request.data(), request.size(), MSG_NOSIGNAL ) != (ssize_t)request.size() )
+			cerr << "send failed" << endl;
+	} );
+	Reader in( fd );
+	string line;
+	int results = 0;
+	while ( in.line( line ) && line != "done" )
+	{
+		istringstream is( line );
+		string type, id;
+		is >> type >> id;
+		size_t i = atoi( id.c_str() );
+		results += type == "result";
+		cout << ( id != "-" && i < files_.size() ? files_[i] : id ) << ": " << line << endl;
+	}
+	sender.join();
+	close( fd );
+	double elapsed = now() - start;
+	cout << results << " positions in " << elapsed << " s (" << (long)( results / elapsed * 60 )
+	     << " positions/min)" << endl;
+	return results == (int)files_.size() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	bool clientMode = false;
+	bool packed = false;
+	vector<string> files;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		string value = i + 1 < argc_ ? argv_[i + 1] : "";
+		if ( arg == "-socket" )
+			socketPath = value, i++;
+		else if ( arg == "-port" )
+			port = atoi( value.c_str() ), i++;
+		else if ( arg == "-j" )
+			threads = atoi( value.c_str() ), i++;
+		else if ( arg == "-hash" )
+			hashSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-time" )
+			searchTime = atof( value.c_str() ), i++;
+		else if ( arg == "-connect" )
+			clientMode = true;
+		else if ( arg == "-packed" )
+			packed = true;
+		else if ( arg[0] != '-' && clientMode )
+			files.push_back( arg );
+		else
+			socketPath.clear(), port = 0, i = argc_;
+	}
+	if ( ( socketPath.empty() && !port ) || threads < 1 || ( clientMode && files.empty() ) )
+	{
+		cerr << "usage: " << argv_[0] << " -socket path|-port n [-j threads] [-hash MB] [-time seconds]" << endl <<
+		     "       " << argv_[0] << " -socket path|-port n -connect [-time seconds] [-packed] board.txt..." << endl;
+		return EXIT_FAILURE;
+	}
+	signal( SIGPIPE, SIG_IGN );
+	return clientMode ? client( files, packed ) : server();
+}
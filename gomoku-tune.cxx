@@ -0,0 +1,351 @@
+/*
+
+ FLTK Gomoku - evaluation tuner
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Fits the weights of the leaf evaluation (see Weights in engine.h) to the
+ results of a corpus of games in binary game files (from gomoku-selfplay
+ -bin or gomoku-games): every quiet position of the games (no five or
+ open four to make, see Engine::evalTerms()) is a sample of the result of
+ its game for the side to move. As the evaluation is a sum of weights
+ times terms, the terms of each sample are counted once (in parallel),
+ then a local search varies one weight at a time and keeps a change if it
+ lowers the mean squared error between the results and sigmoid(K * eval)
+ of all samples (also computed in parallel). K is fitted first for the
+ initial weights, so the tuned weights keep the scale of the evaluation.
+ The weights of the move ordering only (win, win_factor, own_bonus) are
+ not changed.
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include "gamefile.h"
+#include <vector>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <chrono>
+
+using namespace std;
+
+static int parallel = 1;
+static int skipPlies = 6; // opening plies without samples
+static int passes = 100;
+
+// one position: the terms of the evaluation and the result of the game,
+// both from the view of the side to move (1 win, 0.5 draw, 0 loss)
+struct Sample
+{
+	int16_t terms[Weights::W_Count];
+	float result;
+};
+
+static double now()
+//-------------------------------------------------------------------------------
+{
+	return chrono::duration<double>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+// games of all files
+struct Game
+{
+	const GameFile *file;
+	size_t offset;
+};
+
+static void collect( const vector<Game>& games_, atomic<size_t>& next_, int size_,
+                     vector<Sample>& samples_, atomic<long>& positions_ )
+//-------------------------------------------------------------------------------
+{
+	Engine engine( size_ );
+	engine.hashSize( 1 ); // (no search)
+	GameRecord record;
+	int terms[Weights::W_Count];
+	size_t i;
+	while ( ( i = next_++ ) < games_.size() )
+	{
+		size_t offset = games_[i].offset;
+		if ( !games_[i].file->read( offset, record ) || record.type != GameRecord::GR_Game ||
+		     record.result < 1 || record.result > 3 )
+			continue; // (positions and games without result have no samples)
+		engine.clearBoard();
+		int who = record.otherBegan ? 2 : 1;
+		long positions = 0;
+		for ( size_t m = 0; m < record.moves.size(); m++, who = 3 - who )
+		{
+			if ( (int)m >= skipPlies )
+			{
+				positions++;
+				if ( engine.evalTerms( who, terms ) )
+				{
+					Sample s;
+					for ( int t = 0; t < Weights::W_Count; t++ )
+						s.terms[t] = terms[t];
+					s.result = record.result == 3 ? 0.5f : record.result == who ? 1.f : 0.f;
+					samples_.push_back( s );
+				}
+			}
+			const Move& move = record.moves[m];
+			if ( engine.at( move.x, move.y ) )
+				break; // (invalid game)
+			engine.makeMove( move, who );
+		}
+		positions_ += positions;
+	}
+}
+
+static void errorSum( const vector<Sample>& samples_, size_t from_, size_t to_,
+                      const Weights& weights_, double k_, double& sum_ )
+//-------------------------------------------------------------------------------
+{
+	double w[Weights::W_Count];
+	for ( int t = 0; t < Weights::W_Count; t++ )
+		w[t] = weights_[t];
+	double sum = 0;
+	for ( size_t i = from_; i < to_; i++ )
+	{
+		const Sample& s = samples_[i];
+		double e = 0;
+		for ( int t = 0; t < Weights::W_Count; t++ )
+			e += w[t] * s.terms[t];
+		double d = s.result - 1 / ( 1 + exp( -k_ * e ) );
+		sum += d * d;
+	}
+	sum_ = sum;
+}
+
+static long errors = 0; // number of error() calls
+
+static double error( const vector<Sample>& samples_, const Weights& weights_, double k_ )
+//-------------------------------------------------------------------------------
+{
+	// mean squared error of all samples (parts summed in parallel)
+	errors++;
+	vector<double> sums( parallel );
+	vector<thread> workers;
+	size_t part = ( samples_.size() + parallel - 1 ) / parallel;
+	for ( int i = 0; i < parallel; i++ )
+	{
+		size_t from = min( samples_.size(), i * part );
+		size_t to = min( samples_.size(), from + part );
+		workers.emplace_back( errorSum, cref( samples_ ), from, to, cref( weights_ ), k_, ref( sums[i] ) );
+	}
+	double sum = 0;
+	for ( int i = 0; i < parallel; i++ )
+	{
+		workers[i].join();
+		sum += sums[i];
+	}
+	return samples_.empty() ? 0 : sum / samples_.size();
+}
+
+static double fitK( const vector<Sample>& samples_, const Weights& weights_ )
+//-------------------------------------------------------------------------------
+{
+	// K with the least error: coarse by powers of ten, then by
+	// ternary search on log(K) around the best one
+	double best = 1e-6;
+	double bestError = error( samples_, weights_, best );
+	for ( double k = 1e-5; k <= 1; k *= 10 )
+	{
+		double e = error( samples_, weights_, k );
+		if ( e < bestError )
+			best = k, bestError = e;
+	}
+	double lo = log( best / 10 );
+	double hi = log( best * 10 );
+	for ( int i = 0; i < 30; i++ )
+	{
+		double m1 = lo + ( hi - lo ) / 3;
+		double m2 = hi - ( hi - lo ) / 3;
+		if ( error( samples_, weights_, exp( m1 ) ) < error( samples_, weights_, exp( m2 ) ) )
+			hi = m2;
+		else
+			lo = m1;
+	}
+	return exp( ( lo + hi ) / 2 );
+}
+
+static void printWeights( const Weights& weights_, const vector<int>& tuned_ )
+//-------------------------------------------------------------------------------
+{
+	for ( size_t i = 0; i < tuned_.size(); i++ )
+		cout << " " << Weights::name( tuned_[i] ) << " " << weights_[tuned_[i]];
+	cout << endl;
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	parallel = thread::hardware_concurrency();
+	if ( parallel < 1 )
+		parallel = 1;
+	string out;
+	string weightsFile;
+	double k = 0;
+	vector<string> files;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		string value = i + 1 < argc_ ? argv_[i + 1] : "";
+		if ( arg == "-j" )
+			parallel = atoi( value.c_str() ), i++;
+		else if ( arg == "-o" )
+			out = value, i++;
+		else if ( arg == "-weights" )
+			weightsFile = value, i++;
+		else if ( arg == "-skip" )
+			skipPlies = atoi( value.c_str() ), i++;
+		else if ( arg == "-passes" )
+			passes = atoi( value.c_str() ), i++;
+		else if ( arg == "-k" )
+			k = atof( value.c_str() ), i++;
+		else if ( arg[0] != '-' )
+			files.push_back( arg );
+		else
+			files.clear(), i = argc_;
+	}
+	if ( files.empty() || parallel < 1 || k < 0 )
+	{
+		cerr << "usage: " << argv_[0] << " [-j threads] [-weights initial] [-o weights.txt] [-skip plies]" << endl <<
+		     "\t[-passes n] [-k scale] games.gmk..." << endl;
+		return EXIT_FAILURE;
+	}
+	Weights weights;
+	if ( weightsFile.size() && !weights.load( weightsFile ) )
+	{
+		cerr << weightsFile << ": invalid weights" << endl;
+		return EXIT_FAILURE;
+	}
+
+	// all games (the files stay mapped while the samples are collected)
+	vector<std::unique_ptr<GameFile>> gameFiles;
+	vector<Game> games;
+	int size = 0;
+	for ( size_t i = 0; i < files.size(); i++ )
+	{
+		gameFiles.emplace_back( new GameFile );
+		GameFile& f = *gameFiles.back();
+		if ( !f.open( files[i] ) || ( size && f.size() != size ) )
+		{
+			cerr << files[i] << ": no game file" << ( size ? " of board size " + to_string( size ) : "" ) << endl;
+			return EXIT_FAILURE;
+		}
+		size = f.size();
+		GameRecord record;
+		Game game = { &f, f.first() };
+		for ( size_t offset = game.offset; f.read( offset, record ); game.offset = offset )
+			games.push_back( game );
+	}
+
+	double start = now();
+	atomic<size_t> next( 0 );
+	atomic<long> positions( 0 );
+	vector<vector<Sample>> parts( parallel );
+	vector<thread> workers;
+	for ( int i = 0; i < parallel; i++ )
+		workers.emplace_back( collect, cref( games ), ref( next ), size, ref( parts[i] ), ref( positions ) );
+	vector<Sample> samples;
+	for ( int i = 0; i < parallel; i++ )
+	{
+		workers[i].join();
+		samples.insert( samples.end(), parts[i].begin(), parts[i].end() );
+		vector<Sample>().swap( parts[i] );
+	}
+	double elapsed = now() - start;
+	cout << games.size() << " games, " << positions << " positions, " << samples.size() << " quiet in "
+	     << fixed << setprecision( 2 ) << elapsed << " s ("
+	     << setprecision( 0 ) << ( elapsed > 0 ? positions * 60 / elapsed : 0. ) << " positions/min)" << endl;
+	if ( samples.empty() )
+	{
+		cerr << "no samples" << endl;
+		return EXIT_FAILURE;
+	}
+
+	// weights with terms in the samples (those of the leaf evaluation)
+	vector<int> tuned;
+	for ( int t = 0; t < Weights::W_Count; t++ )
+	{
+		size_t i = 0;
+		while ( i < samples.size() && !samples[i].terms[t] )
+			i++;
+		if ( i < samples.size() )
+			tuned.push_back( t );
+	}
+
+	start = now();
+	if ( !k )
+		k = fitK( samples, weights );
+	double best = error( samples, weights, k );
+	cout << "K " << setprecision( 3 ) << scientific << k << fixed << setprecision( 6 ) << ", error " << best << ":";
+	printWeights( weights, tuned );
+
+	// local search: each weight up and down by its step, the step doubled
+	// when this lowers the error, otherwise halved, until all steps are 1
+	// without a change (weights stay at least 1, value() orders the moves too)
+	vector<int> step( Weights::W_Count );
+	for ( size_t i = 0; i < tuned.size(); i++ )
+		step[tuned[i]] = max( 1, weights[tuned[i]] / 4 );
+	for ( int pass = 1; pass <= passes; pass++ )
+	{
+		bool improved = false;
+		bool minimal = true;
+		for ( size_t i = 0; i < tuned.size(); i++ )
+		{
+			int t = tuned[i];
+			bool better = false;
+			for ( int dir = 1; dir >= -1 && !better; dir -= 2 )
+			{
+				Weights w( weights );
+				w[t] += dir * step[t];
+				if ( w[t] < 1 )
+					continue;
+				double e = error( samples, w, k );
+				if ( e < best )
+				{
+					best = e;
+					weights = w;
+					better = true;
+				}
+			}
+			if ( better )
+			{
+				improved = true;
+				step[t] = min( 2 * step[t], max( 1, weights[t] / 4 ) );
+			}
+			else if ( step[t] > 1 )
+				step[t] /= 2;
+			if ( step[t] > 1 )
+				minimal = false;
+		}
+		cout << "pass " << pass << ", error " << best << ":";
+		printWeights( weights, tuned );
+		if ( !improved && minimal )
+			break;
+	}
+	elapsed = now() - start;
+	cout << errors << " evaluations of " << samples.size() << " samples in " << setprecision( 2 ) << elapsed
+	     << " s (" << setprecision( 0 ) << ( elapsed > 0 ? errors * samples.size() * 60 / elapsed : 0. )
+	     << " positions/min)" << endl;
+	if ( out.size() && !weights.save( out ) )
+	{
+		cerr << out << ": can't write" << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
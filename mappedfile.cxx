@@ -0,0 +1,87 @@
+/*
+
+ FLTK Gomoku - read only memory mapped file
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "mappedfile.h"
+#ifdef _WIN32
+#define NO_MMAP
+#include <fstream>
+#include <iterator>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile() :
+	_data( 0 ),
+	_size( 0 ),
+	_map( 0 )
+//-------------------------------------------------------------------------------
+{
+}
+
+MappedFile::~MappedFile()
+//-------------------------------------------------------------------------------
+{
+	close();
+}
+
+void MappedFile::close()
+//-------------------------------------------------------------------------------
+{
+#ifndef NO_MMAP
+	if ( _map )
+		munmap( _map, _size );
+#endif
+	_map = 0;
+	_buffer.clear();
+	_data = 0;
+	_size = 0;
+}
+
+bool MappedFile::open( const string& file_ )
+//-------------------------------------------------------------------------------
+{
+	close();
+#ifndef NO_MMAP
+	int fd = ::open( file_.c_str(), O_RDONLY );
+	if ( fd < 0 )
+		return false;
+	struct stat st;
+	if ( fstat( fd, &st ) == 0 && st.st_size > 0 )
+	{
+		void *p = mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+		if ( p != MAP_FAILED )
+		{
+			_map = p;
+			_data = static_cast<const char *>( p );
+			_size = st.st_size;
+		}
+	}
+	::close( fd );
+#else
+	ifstream ifs( file_.c_str(), ios::binary );
+	_buffer.assign( istreambuf_iterator<char>( ifs ), istreambuf_iterator<char>() );
+	_data = _buffer.data();
+	_size = _buffer.size();
+#endif
+	return _size > 0;
+}
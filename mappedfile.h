@@ -0,0 +1,49 @@
+/*
+
+ FLTK Gomoku - read only memory mapped file
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//-------------------------------------------------------------------------------
+class MappedFile
+//-------------------------------------------------------------------------------
+{
+	// Contents of a file mapped into memory with mmap() (read into
+	// memory on systems without mmap()).
+public:
+	MappedFile();
+	~MappedFile();
+	bool open( const std::string& file_ );
+	void close();
+	const char *data() const { return _data; }
+	size_t size() const { return _size; }
+private:
+	MappedFile( const MappedFile& );
+	MappedFile& operator=( const MappedFile& );
+private:
+	const char *_data;
+	size_t _size;
+	void *_map;
+	std::vector<char> _buffer; // (without mmap)
+};
+
+#endif // MAPPEDFILE_H
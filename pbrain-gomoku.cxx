@@ -0,0 +1,277 @@
+/*
+
+ FLTK Gomoku - Gomocup protocol brain
+
+ (c) 2017-2026 wcout <wcout@gmx.net>
+
+ Plays with the engine over stdin/stdout in the text protocol of the
+ Gomocup tournament managers (Piskvork): START, RESTART, BEGIN, TURN,
+ BOARD, TAKEBACK, INFO, ABOUT and END. Coordinates are 0 based "x,y".
+ The search time of each move follows the INFO limits (timeout_turn,
+ timeout_match with time_left), the transposition table max_memory.
+ Boards from 5x5 up to 20x20 (the Gomocup freestyle board), the engine
+ always plays exactly five (INFO rule is ignored).
+
+ This code is free software: you can redistribute it and/or modify it
+ under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful, but
+ WITHOUT ANY WARRANTY;  without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ See the GNU General Public License for more details:
+ http://www.gnu.org/licenses/.
+
+*/
+#include "engine.h"
+#include <iostream>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <chrono>
+#include <ctime>
+
+using namespace std;
+
+static double now()
+//-------------------------------------------------------------------------------
+{
+	return chrono::duration<double>( chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+//-------------------------------------------------------------------------------
+class Brain
+//-------------------------------------------------------------------------------
+{
+public:
+	Brain( int threads_, int hashSize_, double margin_, bool debug_ );
+	// execute one command line (false on END)
+	bool command( std::string line_ );
+private:
+	void memory();
+	double budget( double start_ ) const;
+	bool cell( const char *s_, int& x_, int& y_ ) const;
+	void play( double start_ );
+	void info( const std::string& key_, const char *value_ );
+private:
+	Engine _engine;
+	int _hashSize; // max. MB (less if max_memory is lower)
+	int _tableSize; // current MB
+	long _timeoutTurn; // ms (0 = as fast as possible)
+	long _timeoutMatch; // ms (0 = no limit)
+	long _timeLeft; // ms (-1 = unknown)
+	long _maxMemory; // bytes (0 = no limit)
+	double _margin; // s reserved for the overhead per move
+};
+
+Brain::Brain( int threads_, int hashSize_, double margin_, bool debug_ ) :
+	_hashSize( hashSize_ ),
+	_tableSize( 0 ),
+	_timeoutTurn( 5000 ),
+	_timeoutMatch( 0 ),
+	_timeLeft( -1 ),
+	_maxMemory( 0 ),
+	_margin( margin_ )
+//-------------------------------------------------------------------------------
+{
+	// (stdout is for the protocol only)
+	_engine.logStream( &cerr );
+	_engine.debug( debug_ );
+	_engine.threads( threads_ );
+	_engine.seed( time( 0 ) );
+	memory();
+}
+
+void Brain::memory()
+//-------------------------------------------------------------------------------
+{
+	// the table may use half of max_memory (the rest is the engine itself)
+	int mb = _hashSize;
+	if ( _maxMemory > 0 && _maxMemory / 2 / ( 1024 * 1024 ) < mb )
+		mb = _maxMemory / 2 / ( 1024 * 1024 );
+	if ( mb < 1 )
+		mb = 1;
+	if ( mb != _tableSize )
+	{
+		_engine.hashSize( mb );
+		_tableSize = mb;
+	}
+}
+
+double Brain::budget( double start_ ) const
+//-------------------------------------------------------------------------------
+{
+	// search time of the next move in seconds (counting from start_)
+	double t = _timeoutTurn > 0 ? _timeoutTurn / 1000. : 0;
+	if ( _timeoutMatch > 0 && _timeLeft >= 0 )
+	{
+		TimeControl clock( TimeControl::TC_SuddenDeath, _timeLeft / 1000. );
+		double c = clock.budget( _engine.pieces(), _engine.size() );
+		if ( t <= 0 || c < t )
+			t = c;
+	}
+	t -= _margin + now() - start_;
+	return t < 0.005 ? 0.005 : t;
+}
+
+bool Brain::cell( const char *s_, int& x_, int& y_ ) const
+//-------------------------------------------------------------------------------
+{
+	// "x,y" (0 based) as engine cell
+	if ( sscanf( s_, "%d,%d", &x_, &y_ ) != 2 )
+		return false;
+	x_++;
+	y_++;
+	return x_ >= 1 && x_ <= _engine.size() && y_ >= 1 && y_ <= _engine.size();
+}
+
+void Brain::play( double start_ )
+//-------------------------------------------------------------------------------
+{
+	// own move (colour 1), the time counts from receiving the command
+	_engine.searchTime( budget( start_ ) );
+	Move move;
+	if ( !_engine.findMove( move, 1 ) && !_engine.randomMove( move ) )
+	{
+		cout << "ERROR no move" << endl;
+		return;
+	}
+	_engine.makeMove( move, 1 );
+	cout << move.x - 1 << ',' << move.y - 1 << endl;
+}
+
+void Brain::info( const string& key_, const char *value_ )
+//-------------------------------------------------------------------------------
+{
+	long value = atol( value_ );
+	if ( key_ == "timeout_turn" )
+		_timeoutTurn = value;
+	else if ( key_ == "timeout_match" )
+		_timeoutMatch = value;
+	else if ( key_ == "time_left" )
+		_timeLeft = value;
+	else if ( key_ == "max_memory" )
+	{
+		_maxMemory = value;
+		memory();
+	}
+}
+
+bool Brain::command( string line_ )
+//-------------------------------------------------------------------------------
+{
+	double start = now();
+	if ( line_.size() && line_.back() == '\r' )
+		line_.pop_back();
+	size_t sep = line_.find( ' ' );
+	string cmd = line_.substr( 0, sep );
+	const char *args = sep == string::npos ? "" : line_.c_str() + sep + 1;
+	for ( size_t i = 0; i < cmd.size(); i++ )
+		cmd[i] = toupper( cmd[i] );
+	int x, y;
+	if ( cmd.empty() )
+		return true;
+	else if ( cmd == "START" )
+	{
+		int size = atoi( args );
+		if ( size < 5 || size > Engine::BS_Max )
+			cout << "ERROR unsupported board size " << size << endl;
+		else
+		{
+			_engine.size( size );
+			cout << "OK" << endl;
+		}
+	}
+	else if ( cmd == "RECTSTART" )
+		cout << "ERROR rectangular boards are not supported" << endl;
+	else if ( cmd == "RESTART" )
+	{
+		_engine.clearBoard();
+		cout << "OK" << endl;
+	}
+	else if ( cmd == "BEGIN" )
+		play( start );
+	else if ( cmd == "TURN" )
+	{
+		if ( !cell( args, x, y ) || _engine.at( x, y ) )
+			cout << "ERROR invalid move '" << args << "'" << endl;
+		else
+		{
+			_engine.setPiece( x, y, 2 );
+			play( start );
+		}
+	}
+	else if ( cmd == "BOARD" )
+	{
+		// "x,y,field" lines up to DONE (1 = own, 2 = opponent's stone)
+		_engine.clearBoard();
+		string l;
+		while ( getline( cin, l ) && l.compare( 0, 4, "DONE" ) )
+		{
+			int who = 0;
+			if ( sscanf( l.c_str(), "%d,%d,%d", &x, &y, &who ) == 3 && ( who == 1 || who == 2 ) &&
+			     cell( l.c_str(), x, y ) && !_engine.at( x, y ) )
+				_engine.setPiece( x, y, who );
+		}
+		play( start );
+	}
+	else if ( cmd == "TAKEBACK" )
+	{
+		if ( !cell( args, x, y ) || _engine.at( x, y ) <= 0 )
+			cout << "ERROR invalid move '" << args << "'" << endl;
+		else
+		{
+			_engine.removePiece( x, y );
+			cout << "OK" << endl;
+		}
+	}
+	else if ( cmd == "INFO" )
+	{
+		const char *value = strchr( args, ' ' );
+		info( string( args, value ? value - args : strlen( args ) ), value ? value + 1 : "" );
+	}
+	else if ( cmd == "ABOUT" )
+		cout << "name=\"fltk-gomoku\", version=\"1.3\", author=\"wcout\"" << endl;
+	else if ( cmd == "END" )
+		return false;
+	else
+		cout << "UNKNOWN command '" << cmd << "'" << endl;
+	return true;
+}
+
+//-------------------------------------------------------------------------------
+int main( int argc_, char *argv_[] )
+//-------------------------------------------------------------------------------
+{
+	int threads = 1;
+	int hashSize = 64;
+	double margin = 0.03;
+	bool debug = false;
+	for ( int i = 1; i < argc_; i++ )
+	{
+		string arg = argv_[i];
+		string value = i + 1 < argc_ ? argv_[i + 1] : "";
+		if ( arg == "-threads" )
+			threads = atoi( value.c_str() ), i++;
+		else if ( arg == "-hash" )
+			hashSize = atoi( value.c_str() ), i++;
+		else if ( arg == "-margin" )
+			margin = atof( value.c_str() ) / 1000, i++;
+		else if ( arg == "-debug" )
+			debug = true;
+		else
+		{
+			cerr << "usage: " << argv_[0] << " [-threads n] [-hash MB] [-margin ms] [-debug]" << endl;
+			return EXIT_FAILURE;
+		}
+	}
+	ios::sync_with_stdio( false );
+	Brain brain( threads, hashSize, margin, debug );
+	string line;
+	while ( getline( cin, line ) && brain.command( line ) )
+		;
+	return EXIT_SUCCESS;
+}